@@ -0,0 +1,200 @@
+/*
+ * Copyright (C) 2026 Artem Svitlov (Moscow, Russia)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// Precompiled script cache. LoadScript() is luaL_loadfile() with a cache directory in front of
+// it: the first load dumps the compiled chunk (lua_dump) next to the source's size, mtime and
+// hash, later loads skip the lexer and parser and read the bytecode with luaL_loadbuffer().
+//
+// An entry is used as is when size and mtime still match. Otherwise the source is hashed: same
+// hash (file copied or touched) refreshes the entry, a different one recompiles and rewrites
+// it. Bytecode from another Lua build fails the loader's header check and falls back to source
+// too. `luacache` (make luacache) fills the cache ahead of time.
+
+#ifndef MOONRAY_BYTECODE_CACHE_H
+#define MOONRAY_BYTECODE_CACHE_H
+
+#include "lua.hpp"
+#include <string>
+#include <vector>
+#include <fstream>
+#include <filesystem>
+#include <system_error>
+#include <thread>
+#include <functional>
+#include <cstdint>
+#include <cstring>
+#include <cstdio>
+
+namespace MoonRay {
+    namespace BytecodeCache {
+        struct Header {
+            char magic[8];              // "MRLUAC1\0"
+            uint32_t luaVersion;        // LUA_VERSION_NUM of the build that wrote the entry
+            uint32_t reserved;
+            uint64_t sourceSize;
+            int64_t sourceTime;         // Source last write time, file clock ticks
+            uint64_t sourceHash;        // FNV-1a of the source bytes
+            uint64_t bytecodeSize;
+        };
+
+        constexpr char Magic[8] = { 'M', 'R', 'L', 'U', 'A', 'C', '1', '\0' };
+
+        // Cache location; empty disables the cache. Set it before scripts are loaded.
+        inline std::string& Directory() {
+            static std::string directory = ".luacache";
+            return directory;
+        }
+
+        inline uint64_t Hash(const char* data, size_t size) {
+            uint64_t hash = 0xcbf29ce484222325ull;
+            for (size_t i = 0; i < size; i++) {
+                hash ^= (unsigned char)data[i];
+                hash *= 0x100000001b3ull;
+            }
+            return hash;
+        }
+
+        // "./lua/a.lua" and "lua/a.lua" name the same script
+        inline std::string NormalizePath(const std::string& path) {
+            return std::filesystem::path(path).lexically_normal().generic_string();
+        }
+
+        // One entry per script path
+        inline std::filesystem::path EntryPath(const std::string& path) {
+            std::string key = NormalizePath(path);
+            char name[32];
+            snprintf(name, sizeof(name), "%016llx.luac", (unsigned long long)Hash(key.data(), key.size()));
+            return std::filesystem::path(Directory()) / name;
+        }
+
+        inline bool ReadFile(const std::filesystem::path& path, std::vector<char>& out) {
+            std::ifstream file(path, std::ios::binary | std::ios::ate);
+            if (!file) return false;
+            std::streamoff size = file.tellg();
+            if (size < 0) return false;
+            out.resize((size_t)size);
+            file.seekg(0);
+            return file.read(out.data(), size) || size == 0;
+        }
+
+        // Shards compile the same scripts concurrently: write a private file, then rename it over the entry
+        inline void WriteEntry(const std::filesystem::path& entry, const Header& header, const char* bytecode) {
+            std::error_code ec;
+            std::filesystem::create_directories(entry.parent_path(), ec);
+
+            std::filesystem::path temp = entry;
+            temp += "." + std::to_string(std::hash<std::thread::id>()(std::this_thread::get_id())) + ".tmp";
+            {
+                std::ofstream file(temp, std::ios::binary | std::ios::trunc);
+                if (!file) return;
+                file.write(reinterpret_cast<const char*>(&header), sizeof(header));
+                file.write(bytecode, (std::streamsize)header.bytecodeSize);
+                if (!file) {
+                    file.close();
+                    std::filesystem::remove(temp, ec);
+                    return;
+                }
+            }
+            std::filesystem::rename(temp, entry, ec);
+            if (ec) std::filesystem::remove(temp, ec);
+        }
+
+        inline int DumpWriter(lua_State*, const void* p, size_t size, void* ud) {
+            auto* out = static_cast<std::vector<char>*>(ud);
+            out->insert(out->end(), static_cast<const char*>(p), static_cast<const char*>(p) + size);
+            return 0;
+        }
+
+        // Same handling of a UTF-8 BOM and a '#' first line as luaL_loadfile (line numbers are kept)
+        inline int LoadSource(lua_State* L, const std::vector<char>& source, const std::string& chunkName) {
+            const char* data = source.data();
+            size_t size = source.size();
+            if (size >= 3 && memcmp(data, "\xEF\xBB\xBF", 3) == 0) { data += 3; size -= 3; }
+            if (size > 0 && data[0] == '#') {
+                while (size > 0 && *data != '\n') { data++; size--; }
+            }
+            return luaL_loadbuffer(L, data, size, chunkName.c_str());
+        }
+
+        // Compiles the source and rewrites the cache entry, same result as luaL_loadbuffer
+        inline int Build(lua_State* L, const std::string& path, const std::vector<char>& source, uint64_t hash,
+                          uint64_t size, int64_t time, const std::filesystem::path& entry) {
+            int status = LoadSource(L, source, "@" + path);
+            if (status != LUA_OK) return status;
+
+            std::vector<char> bytecode;
+            if (lua_dump(L, DumpWriter, &bytecode, 0) != 0) return LUA_OK;
+
+            Header header = {};
+            memcpy(header.magic, Magic, sizeof(Magic));
+            header.luaVersion = LUA_VERSION_NUM;
+            header.sourceSize = size;
+            header.sourceTime = time;
+            header.sourceHash = hash;
+            header.bytecodeSize = bytecode.size();
+            WriteEntry(entry, header, bytecode.data());
+            return LUA_OK;
+        }
+
+        // Drop-in for luaL_loadfile: pushes the compiled chunk, or an error message
+        inline int LoadScript(lua_State* L, const std::string& path) {
+            if (Directory().empty()) return luaL_loadfile(L, path.c_str());
+
+            std::error_code ec;
+            uint64_t size = std::filesystem::file_size(path, ec);
+            if (ec) return luaL_loadfile(L, path.c_str());
+            int64_t time = (int64_t)std::filesystem::last_write_time(path, ec).time_since_epoch().count();
+            if (ec) return luaL_loadfile(L, path.c_str());
+
+            const std::string chunkName = "@" + path;
+            const std::filesystem::path entry = EntryPath(path);
+            std::vector<char> cached;
+            const Header* header = nullptr;
+            if (ReadFile(entry, cached) && cached.size() >= sizeof(Header)) {
+                header = reinterpret_cast<const Header*>(cached.data());
+                if (memcmp(header->magic, Magic, sizeof(Magic)) != 0 || header->luaVersion != LUA_VERSION_NUM ||
+                    header->bytecodeSize != cached.size() - sizeof(Header)) {
+                    header = nullptr;
+                }
+            }
+
+            auto loadCached = [&] {
+                const char* bytecode = cached.data() + sizeof(Header);
+                if (luaL_loadbufferx(L, bytecode, (size_t)header->bytecodeSize, chunkName.c_str(), "b") == LUA_OK) return true;
+                lua_pop(L, 1);
+                return false;
+            };
+
+            if (header && header->sourceSize == size && header->sourceTime == time && loadCached()) return LUA_OK;
+
+            std::vector<char> source;
+            if (!ReadFile(path, source)) return luaL_loadfile(L, path.c_str());
+            uint64_t hash = Hash(source.data(), source.size());
+
+            if (header && header->sourceHash == hash && header->sourceSize == size && loadCached()) {
+                Header refreshed = *header;
+                refreshed.sourceTime = time;
+                WriteEntry(entry, refreshed, cached.data() + sizeof(Header));
+                return LUA_OK;
+            }
+
+            return Build(L, path, source, hash, size, time, entry);
+        }
+    }
+}
+
+#endif
@@ -0,0 +1,178 @@
+/*
+ * Copyright (C) 2026 Artem Svitlov (Moscow, Russia)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// Allocator for lua_newstate(). Lua allocates mostly small fixed-size objects (strings, tables,
+// closures, upvalues, hash nodes), which are served from per-size-class free lists carved out
+// of larger chunks; anything above MaxPooledSize goes to malloc. Lua passes the old block size
+// back on every realloc/free, so blocks carry no header.
+//
+// One allocator per lua_State and no locking: a state is only ever used by one thread at a time.
+// It also keeps the state's accounting and enforces an optional hard limit: an allocation that
+// would go over it fails, Lua runs an emergency collection and raises "not enough memory" if
+// that doesn't help. The limit only applies while enforcing is set (ScriptVM sets it around
+// protected script calls); the engine's own API calls outside a pcall must not fail.
+
+#ifndef MOONRAY_LUA_ALLOCATOR_H
+#define MOONRAY_LUA_ALLOCATOR_H
+
+#include <vector>
+#include <algorithm>
+#include <cstdlib>
+#include <cstring>
+#include <cstdint>
+#include <cstddef>
+
+namespace MoonRay {
+    class LuaPoolAllocator {
+    public:
+        static constexpr size_t Granularity = 16;
+        static constexpr size_t MaxPooledSize = 256;
+        static constexpr size_t ClassCount = MaxPooledSize / Granularity;
+        static constexpr size_t FirstChunkSize = 4 * 1024;     // Grows x2 per refill, so small VMs stay small
+        static constexpr size_t MaxChunkSize = 64 * 1024;
+
+        struct Stats {
+            size_t inUse = 0;           // Bytes Lua holds (same as collectgarbage("count") * 1024)
+            size_t peak = 0;
+            size_t reserved = 0;        // Bytes in pool chunks, used or not
+            size_t limit = 0;           // 0 = unlimited
+            uint64_t allocations = 0;
+            uint64_t failed = 0;        // Allocations refused by the limit
+        };
+
+    private:
+        struct FreeBlock {
+            FreeBlock* next;
+        };
+
+        FreeBlock* freeLists[ClassCount] = {};
+        size_t chunkSize[ClassCount];
+        std::vector<void*> chunks;
+        Stats stats;
+        bool enforcing = false;
+
+        static size_t ClassOf(size_t size) { return (size - 1) / Granularity; }
+        static bool Pooled(size_t size) { return size <= MaxPooledSize; }
+
+        bool Refill(size_t cls) {
+            const size_t blockSize = (cls + 1) * Granularity;
+            const size_t bytes = chunkSize[cls];
+            char* chunk = static_cast<char*>(malloc(bytes));
+            if (!chunk) return false;
+            chunks.push_back(chunk);
+            chunkSize[cls] = std::min(bytes * 2, MaxChunkSize);
+            stats.reserved += bytes;
+
+            for (size_t offset = 0; offset + blockSize <= bytes; offset += blockSize) {
+                FreeBlock* block = reinterpret_cast<FreeBlock*>(chunk + offset);
+                block->next = freeLists[cls];
+                freeLists[cls] = block;
+            }
+            return true;
+        }
+
+        void* Allocate(size_t size) {
+            if (!Pooled(size)) return malloc(size);
+            size_t cls = ClassOf(size);
+            if (!freeLists[cls] && !Refill(cls)) return nullptr;
+            FreeBlock* block = freeLists[cls];
+            freeLists[cls] = block->next;
+            return block;
+        }
+
+        void Release(void* ptr, size_t size) {
+            if (!Pooled(size)) {
+                free(ptr);
+                return;
+            }
+            FreeBlock* block = static_cast<FreeBlock*>(ptr);
+            size_t cls = ClassOf(size);
+            block->next = freeLists[cls];
+            freeLists[cls] = block;
+        }
+
+        void* Reallocate(void* ptr, size_t osize, size_t nsize) {
+            if (!ptr) osize = 0;    // osize is the object type tag for new blocks
+
+            if (nsize == 0) {
+                if (ptr) Release(ptr, osize);
+                stats.inUse -= osize;
+                return nullptr;
+            }
+
+            if (nsize > osize && enforcing && stats.limit != 0 && stats.inUse - osize + nsize > stats.limit) {
+                stats.failed++;
+                return nullptr;
+            }
+
+            void* block;
+            if (ptr && Pooled(osize) && Pooled(nsize) && ClassOf(osize) == ClassOf(nsize)) {
+                block = ptr;
+            } else if (ptr && !Pooled(osize) && !Pooled(nsize)) {
+                block = realloc(ptr, nsize);
+                if (!block) return nullptr;
+            } else {
+                block = Allocate(nsize);
+                if (!block) {
+                    // Lua requires shrinking to succeed. The old block is at least as large; it ends
+                    // up in the smaller size class when freed.
+                    if (ptr && nsize < osize) block = ptr;
+                    else return nullptr;
+                } else if (ptr) {
+                    memcpy(block, ptr, std::min(osize, nsize));
+                    Release(ptr, osize);
+                }
+            }
+
+            if (!ptr) stats.allocations++;
+            stats.inUse = stats.inUse - osize + nsize;
+            stats.peak = std::max(stats.peak, stats.inUse);
+            return block;
+        }
+
+    public:
+        LuaPoolAllocator() {
+            std::fill(chunkSize, chunkSize + ClassCount, FirstChunkSize);
+        }
+
+        ~LuaPoolAllocator() {
+            for (void* chunk : chunks) free(chunk);
+        }
+
+        LuaPoolAllocator(const LuaPoolAllocator&) = delete;
+        LuaPoolAllocator& operator=(const LuaPoolAllocator&) = delete;
+
+        // lua_Alloc, with the allocator as ud: lua_newstate(LuaPoolAllocator::Alloc, &allocator)
+        static void* Alloc(void* ud, void* ptr, size_t osize, size_t nsize) {
+            return static_cast<LuaPoolAllocator*>(ud)->Reallocate(ptr, osize, nsize);
+        }
+
+        // Hard cap on inUse, 0 = unlimited. Blocks already allocated are never taken back.
+        void SetLimit(size_t bytes) { stats.limit = bytes; }
+
+        // Returns the previous value, for nesting
+        bool SetEnforcing(bool value) {
+            bool previous = enforcing;
+            enforcing = value;
+            return previous;
+        }
+
+        const Stats& GetStats() const { return stats; }
+    };
+}
+
+#endif
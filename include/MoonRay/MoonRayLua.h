@@ -24,11 +24,177 @@
 #include "lua.hpp"
 #include "raylib.h"
 #include "raymath.h"
+#include "core/RenderQueue.h"
+#include "core/CommandQueue.h"
+#include "core/AssetCache.h"
+#include "core/InputSnapshot.h"
 #include <string>
 #include <vector>
+#include <cstring>
+#include <cmath>
+#include <type_traits>
+#include <cstdint>
+#include <algorithm>
+#include <random>
 
 namespace MoonRay {
+    // --- Value types ---
+    // Vector2, Vector3, Color and Rectangle are passed to Lua as full userdata with a metatable:
+    // fields (v.x, c.r, r.width), array-style indices (v[1]) for code written against the old
+    // table form, arithmetic metamethods on the vectors and in-place methods that don't allocate.
+    // Plain tables are still accepted everywhere a value is expected.
+
+    template <typename T> struct ValueType;
+
+    template <> struct ValueType<Vector2> {
+        using Component = float;
+        static constexpr int Count = 2;
+        static const char* Name() { return "Vector2"; }
+        static constexpr uint64_t Tag = 0x4D52566563320000ull;
+        static const char* Field(int i) { static const char* const fields[] = { "x", "y" }; return fields[i]; }
+    };
+
+    template <> struct ValueType<Vector3> {
+        using Component = float;
+        static constexpr int Count = 3;
+        static const char* Name() { return "Vector3"; }
+        static constexpr uint64_t Tag = 0x4D52566563330000ull;
+        static const char* Field(int i) { static const char* const fields[] = { "x", "y", "z" }; return fields[i]; }
+    };
+
+    template <> struct ValueType<Rectangle> {
+        using Component = float;
+        static constexpr int Count = 4;
+        static const char* Name() { return "Rectangle"; }
+        static constexpr uint64_t Tag = 0x4D52526563740000ull;
+        static const char* Field(int i) { static const char* const fields[] = { "x", "y", "width", "height" }; return fields[i]; }
+    };
+
+    template <> struct ValueType<Color> {
+        using Component = unsigned char;
+        static constexpr int Count = 4;
+        static const char* Name() { return "Color"; }
+        static constexpr uint64_t Tag = 0x4D52436F6C720000ull;
+        static const char* Field(int i) { static const char* const fields[] = { "r", "g", "b", "a" }; return fields[i]; }
+    };
+
+    // All four types are plain arrays of one component type
+    template <typename T>
+    inline typename ValueType<T>::Component* Components(T& value) {
+        return reinterpret_cast<typename ValueType<T>::Component*>(&value);
+    }
+
+    // Userdata block: the tag identifies the type without a metatable lookup
+    template <typename T>
+    struct TaggedValue {
+        uint64_t tag;
+        T value;
+    };
+
+    // Registry key of the type's metatable (the address is unique per type)
+    template <typename T>
+    inline void* ValueKey() {
+        static char key;
+        return &key;
+    }
+
+    // Set in the tag of values shared by every script of a VM (the API's color constants)
+    constexpr uint64_t ReadOnlyBit = 1;
+
+    // The value behind stackIndex if it is a T userdata, nullptr otherwise
+    template <typename T>
+    inline T* TestValue(lua_State* L, int stackIndex) {
+        if (lua_type(L, stackIndex) != LUA_TUSERDATA || lua_rawlen(L, stackIndex) != sizeof(TaggedValue<T>)) return nullptr;
+        auto* data = static_cast<TaggedValue<T>*>(lua_touserdata(L, stackIndex));
+        return (data->tag & ~ReadOnlyBit) == ValueType<T>::Tag ? &data->value : nullptr;
+    }
+
+    // Like TestValue, but nullptr for read-only values
+    template <typename T>
+    inline T* TestMutableValue(lua_State* L, int stackIndex) {
+        T* value = TestValue<T>(L, stackIndex);
+        return value && !(static_cast<TaggedValue<T>*>(lua_touserdata(L, stackIndex))->tag & ReadOnlyBit) ? value : nullptr;
+    }
+
+    // For metamethods, where the first operand is known to be a T
+    template <typename T>
+    inline T* ToValue(lua_State* L, int stackIndex) {
+        return &static_cast<TaggedValue<T>*>(lua_touserdata(L, stackIndex))->value;
+    }
+
+    template <typename T>
+    inline T* CheckValue(lua_State* L, int stackIndex) {
+        T* value = TestValue<T>(L, stackIndex);
+        if (!value) luaL_argerror(L, stackIndex, lua_pushfstring(L, "%s expected", ValueType<T>::Name()));
+        return value;
+    }
+
+    // For methods that modify the value
+    template <typename T>
+    inline T* CheckMutableValue(lua_State* L, int stackIndex) {
+        T* value = CheckValue<T>(L, stackIndex);
+        if (!TestMutableValue<T>(L, stackIndex)) luaL_argerror(L, stackIndex, lua_pushfstring(L, "%s is read-only, Copy() it first", ValueType<T>::Name()));
+        return value;
+    }
+
+    template <typename T>
+    inline T& PushValue(lua_State* L, const T& value) {
+        auto* data = static_cast<TaggedValue<T>*>(lua_newuserdata(L, sizeof(TaggedValue<T>)));
+        data->tag = ValueType<T>::Tag;
+        data->value = value;
+        lua_rawgetp(L, LUA_REGISTRYINDEX, ValueKey<T>());
+        lua_setmetatable(L, -2);
+        return data->value;
+    }
+
+    // A value scripts can read and Copy() but not modify
+    template <typename T>
+    inline void PushReadOnlyValue(lua_State* L, const T& value) {
+        PushValue(L, value);
+        static_cast<TaggedValue<T>*>(lua_touserdata(L, -1))->tag |= ReadOnlyBit;
+    }
+
+    // Userdata or { x, y, ... } table; anything else reads as zero
+    template <typename T>
+    inline T GetValue(lua_State* L, int stackIndex) {
+        if (T* value = TestValue<T>(L, stackIndex)) return *value;
+
+        T result = {};
+        if (lua_istable(L, stackIndex)) {
+            auto* c = Components(result);
+            for (int i = 0; i < ValueType<T>::Count; i++) {
+                lua_rawgeti(L, stackIndex, i + 1);
+                c[i] = (typename ValueType<T>::Component)lua_tonumber(L, -1);
+            }
+            lua_pop(L, ValueType<T>::Count);
+        }
+        return result;
+    }
+
+    // Writes into the userdata at outIndex when one was passed (no allocation), pushes a new one otherwise
+    template <typename T>
+    inline void PushResult(lua_State* L, const T& value, int outIndex) {
+        if (T* out = TestMutableValue<T>(L, outIndex)) {
+            *out = value;
+            lua_pushvalue(L, outIndex);
+        } else {
+            PushValue(L, value);
+        }
+    }
+
+    // Packed 0xRRGGBBAA colors, the integers ColorToInt and GetColor use in Lua
+    inline uint32_t ColorBits(Color c) {
+        return ((uint32_t)c.r << 24) | ((uint32_t)c.g << 16) | ((uint32_t)c.b << 8) | c.a;
+    }
+
+    inline Color ColorFromBits(uint32_t bits) {
+        return { (unsigned char)(bits >> 24), (unsigned char)(bits >> 16), (unsigned char)(bits >> 8), (unsigned char)bits };
+    }
+
+    // A packed integer, a Color or a { r, g, b, a } table; anything else reads as BLUE
     inline Color GetColorFromLua(lua_State* L, int stackIndex) {
+        if (lua_isinteger(L, stackIndex)) return ColorFromBits((uint32_t)lua_tointeger(L, stackIndex));
+        if (Color* color = TestValue<Color>(L, stackIndex)) return *color;
         if (lua_istable(L, stackIndex)) {
             lua_rawgeti(L, stackIndex, 1); int r = (int)lua_tointeger(L, -1);
             lua_rawgeti(L, stackIndex, 2); int g = (int)lua_tointeger(L, -1);
@@ -41,6 +207,7 @@ namespace MoonRay {
     }
 
     inline Vector2 GetVector2FromLua(lua_State* L, int stackIndex) {
+        if (Vector2* value = TestValue<Vector2>(L, stackIndex)) return *value;
         Vector2 vec = {0, 0};
         if (lua_istable(L, stackIndex)) {
             lua_rawgeti(L, stackIndex, 1); vec.x = (float)lua_tonumber(L, -1);
@@ -51,6 +218,7 @@ namespace MoonRay {
     }
 
     inline Vector3 GetVector3FromLua(lua_State* L, int stackIndex) {
+        if (Vector3* value = TestValue<Vector3>(L, stackIndex)) return *value;
         Vector3 vec = {0, 0, 0};
         if (lua_istable(L, stackIndex)) {
             lua_rawgeti(L, stackIndex, 1); vec.x = (float)lua_tonumber(L, -1);
@@ -62,6 +230,7 @@ namespace MoonRay {
     }
 
     inline Rectangle GetRectangleFromLua(lua_State* L, int stackIndex) {
+        if (Rectangle* value = TestValue<Rectangle>(L, stackIndex)) return *value;
         Rectangle rect = {0, 0, 0, 0};
         if (lua_istable(L, stackIndex)) {
             lua_rawgeti(L, stackIndex, 1); rect.x = (float)lua_tonumber(L, -1);
@@ -75,26 +244,815 @@ namespace MoonRay {
 
     
     inline void PushColorToLua(lua_State* L, Color color) {
-        lua_createtable(L, 4, 0);
-        lua_pushinteger(L, color.r); lua_rawseti(L, -2, 1);
-        lua_pushinteger(L, color.g); lua_rawseti(L, -2, 2);
-        lua_pushinteger(L, color.b); lua_rawseti(L, -2, 3);
-        lua_pushinteger(L, color.a); lua_rawseti(L, -2, 4);
+        PushValue(L, color);
     }
 
     
     inline void PushVector2ToLua(lua_State* L, Vector2 vec) {
-        lua_createtable(L, 2, 0);
-        lua_pushnumber(L, vec.x); lua_rawseti(L, -2, 1);
-        lua_pushnumber(L, vec.y); lua_rawseti(L, -2, 2);
+        PushValue(L, vec);
     }
 
     
     inline void PushVector3ToLua(lua_State* L, Vector3 vec) {
-        lua_createtable(L, 3, 0);
-        lua_pushnumber(L, vec.x); lua_rawseti(L, -2, 1);
-        lua_pushnumber(L, vec.y); lua_rawseti(L, -2, 2);
-        lua_pushnumber(L, vec.z); lua_rawseti(L, -2, 3);
+        PushValue(L, vec);
+    }
+
+    // --- Value type metatables ---
+
+    template <typename T>
+    inline void PushComponent(lua_State* L, T& value, int i) {
+        if (std::is_same<typename ValueType<T>::Component, float>::value) lua_pushnumber(L, Components(value)[i]);
+        else lua_pushinteger(L, (lua_Integer)Components(value)[i]);
+    }
+
+    // Component index for v[1] or v.x style keys, -1 if the key is not a component
+    template <typename T>
+    inline int ComponentIndex(lua_State* L, int keyIndex) {
+        if (lua_type(L, keyIndex) == LUA_TNUMBER) {
+            lua_Integer i = lua_tointeger(L, keyIndex);
+            return (i >= 1 && i <= ValueType<T>::Count) ? (int)i - 1 : -1;
+        }
+        const char* key = lua_tostring(L, keyIndex);
+        if (!key) return -1;
+        for (int i = 0; i < ValueType<T>::Count; i++) {
+            if (strcmp(key, ValueType<T>::Field(i)) == 0) return i;
+        }
+        return -1;
+    }
+
+    // __index: components first, then the methods table (upvalue 1)
+    template <typename T>
+    inline int l_ValueIndex(lua_State* L) {
+        T* value = ToValue<T>(L, 1);
+        int i = ComponentIndex<T>(L, 2);
+        if (i >= 0) {
+            PushComponent(L, *value, i);
+            return 1;
+        }
+        lua_pushvalue(L, 2);
+        lua_rawget(L, lua_upvalueindex(1));
+        return 1;
+    }
+
+    template <typename T>
+    inline int l_ValueNewIndex(lua_State* L) {
+        T* value = CheckMutableValue<T>(L, 1);
+        int i = ComponentIndex<T>(L, 2);
+        if (i < 0) return luaL_error(L, "%s has no field '%s'", ValueType<T>::Name(), luaL_tolstring(L, 2, nullptr));
+        Components(*value)[i] = (typename ValueType<T>::Component)luaL_checknumber(L, 3);
+        return 0;
+    }
+
+    template <typename T>
+    inline int l_ValueLen(lua_State* L) {
+        lua_pushinteger(L, ValueType<T>::Count);
+        return 1;
+    }
+
+    template <typename T>
+    inline int l_ValueEq(lua_State* L) {
+        T* a = TestValue<T>(L, 1);
+        T* b = TestValue<T>(L, 2);
+        lua_pushboolean(L, a && b && memcmp(a, b, sizeof(T)) == 0);
+        return 1;
+    }
+
+    template <typename T>
+    inline int l_ValueToString(lua_State* L) {
+        T* value = ToValue<T>(L, 1);
+        luaL_Buffer b;
+        luaL_buffinit(L, &b);
+        luaL_addstring(&b, ValueType<T>::Name());
+        luaL_addchar(&b, '(');
+        for (int i = 0; i < ValueType<T>::Count; i++) {
+            if (i > 0) luaL_addstring(&b, ", ");
+            PushComponent(L, *value, i);
+            luaL_addvalue(&b);
+        }
+        luaL_addchar(&b, ')');
+        luaL_pushresult(&b);
+        return 1;
+    }
+
+    // Set(x, y, ...) or Set(other): overwrites self, returns self
+    template <typename T>
+    inline int l_ValueSet(lua_State* L) {
+        T* value = CheckMutableValue<T>(L, 1);
+        if (lua_type(L, 2) == LUA_TNUMBER) {
+            for (int i = 0; i < ValueType<T>::Count; i++) {
+                Components(*value)[i] = (typename ValueType<T>::Component)luaL_optnumber(L, i + 2, 0);
+            }
+        } else {
+            *value = GetValue<T>(L, 2);
+        }
+        lua_settop(L, 1);
+        return 1;
+    }
+
+    template <typename T>
+    inline int l_ValueCopy(lua_State* L) {
+        PushValue(L, *CheckValue<T>(L, 1));
+        return 1;
+    }
+
+    // Constructor: Vector2(x, y), Vector2(other) or Vector2() for zero
+    template <typename T>
+    inline int l_ValueNew(lua_State* L) {
+        T value = {};
+        if (lua_gettop(L) >= 1 && lua_type(L, 1) != LUA_TNUMBER) {
+            value = GetValue<T>(L, 1);
+        } else {
+            for (int i = 0; i < ValueType<T>::Count; i++) {
+                Components(value)[i] = (typename ValueType<T>::Component)luaL_optnumber(L, i + 1, 0);
+            }
+        }
+        PushValue(L, value);
+        return 1;
+    }
+
+    // Vector arithmetic. Operators return a new value; the methods of the same name work in place.
+
+    template <typename T>
+    inline T VectorOp(const T& a, const T& b, float (*op)(float, float)) {
+        T result;
+        for (int i = 0; i < ValueType<T>::Count; i++) {
+            Components(result)[i] = op(Components(const_cast<T&>(a))[i], Components(const_cast<T&>(b))[i]);
+        }
+        return result;
+    }
+
+    inline float OpAdd(float a, float b) { return a + b; }
+    inline float OpSub(float a, float b) { return a - b; }
+    inline float OpMul(float a, float b) { return a * b; }
+    inline float OpDiv(float a, float b) { return a / b; }
+
+    // Operand as a vector: numbers are broadcast (v * 2, 2 * v)
+    template <typename T>
+    inline T VectorOperand(lua_State* L, int stackIndex) {
+        if (lua_type(L, stackIndex) == LUA_TNUMBER) {
+            T value;
+            float n = (float)lua_tonumber(L, stackIndex);
+            for (int i = 0; i < ValueType<T>::Count; i++) Components(value)[i] = n;
+            return value;
+        }
+        return GetValue<T>(L, stackIndex);
+    }
+
+    template <typename T, float (*Op)(float, float)>
+    inline int l_VectorArith(lua_State* L) {
+        PushValue(L, VectorOp(VectorOperand<T>(L, 1), VectorOperand<T>(L, 2), Op));
+        return 1;
+    }
+
+    template <typename T, float (*Op)(float, float)>
+    inline int l_VectorArithInPlace(lua_State* L) {
+        T* self = CheckMutableValue<T>(L, 1);
+        *self = VectorOp(*self, VectorOperand<T>(L, 2), Op);
+        lua_settop(L, 1);
+        return 1;
+    }
+
+    template <typename T>
+    inline int l_VectorUnm(lua_State* L) {
+        T value = *ToValue<T>(L, 1);
+        for (int i = 0; i < ValueType<T>::Count; i++) Components(value)[i] = -Components(value)[i];
+        PushValue(L, value);
+        return 1;
+    }
+
+    template <typename T>
+    inline float VectorDot(const T& a, const T& b) {
+        float sum = 0.0f;
+        for (int i = 0; i < ValueType<T>::Count; i++) sum += Components(const_cast<T&>(a))[i] * Components(const_cast<T&>(b))[i];
+        return sum;
+    }
+
+    template <typename T>
+    inline int l_VectorDot(lua_State* L) {
+        lua_pushnumber(L, VectorDot(*CheckValue<T>(L, 1), GetValue<T>(L, 2)));
+        return 1;
+    }
+
+    template <typename T>
+    inline int l_VectorLength(lua_State* L) {
+        T* self = CheckValue<T>(L, 1);
+        lua_pushnumber(L, sqrtf(VectorDot(*self, *self)));
+        return 1;
+    }
+
+    template <typename T>
+    inline int l_VectorLengthSqr(lua_State* L) {
+        T* self = CheckValue<T>(L, 1);
+        lua_pushnumber(L, VectorDot(*self, *self));
+        return 1;
+    }
+
+    template <typename T>
+    inline int l_VectorDistance(lua_State* L) {
+        T d = VectorOp(*CheckValue<T>(L, 1), GetValue<T>(L, 2), OpSub);
+        lua_pushnumber(L, sqrtf(VectorDot(d, d)));
+        return 1;
+    }
+
+    template <typename T>
+    inline int l_VectorNormalizeInPlace(lua_State* L) {
+        T* self = CheckMutableValue<T>(L, 1);
+        float length = sqrtf(VectorDot(*self, *self));
+        if (length > 0.0f) {
+            for (int i = 0; i < ValueType<T>::Count; i++) Components(*self)[i] /= length;
+        }
+        lua_settop(L, 1);
+        return 1;
+    }
+
+    template <typename T>
+    inline int l_VectorLerpInPlace(lua_State* L) {
+        T* self = CheckMutableValue<T>(L, 1);
+        T target = GetValue<T>(L, 2);
+        float t = (float)luaL_checknumber(L, 3);
+        for (int i = 0; i < ValueType<T>::Count; i++) {
+            Components(*self)[i] += (Components(target)[i] - Components(*self)[i]) * t;
+        }
+        lua_settop(L, 1);
+        return 1;
+    }
+
+    inline int l_Vector2RotateInPlace(lua_State* L) {
+        Vector2* self = CheckMutableValue<Vector2>(L, 1);
+        *self = Vector2Rotate(*self, (float)luaL_checknumber(L, 2));
+        lua_settop(L, 1);
+        return 1;
+    }
+
+    inline int l_Vector3CrossInPlace(lua_State* L) {
+        Vector3* self = CheckMutableValue<Vector3>(L, 1);
+        *self = Vector3CrossProduct(*self, GetValue<Vector3>(L, 2));
+        lua_settop(L, 1);
+        return 1;
+    }
+
+    // Creates the metatable and stores it under ValueKey<T>(). The constructor is in ApiEntries().
+    template <typename T>
+    inline void RegisterValueType(lua_State* L, const luaL_Reg* methods, const luaL_Reg* metamethods) {
+        luaL_newmetatable(L, ValueType<T>::Name());
+
+        lua_newtable(L);
+        luaL_setfuncs(L, methods, 0);
+        lua_pushcclosure(L, l_ValueIndex<T>, 1);
+        lua_setfield(L, -2, "__index");
+
+        const luaL_Reg common[] = {
+            { "__newindex", l_ValueNewIndex<T> },
+            { "__len", l_ValueLen<T> },
+            { "__eq", l_ValueEq<T> },
+            { "__tostring", l_ValueToString<T> },
+            { nullptr, nullptr }
+        };
+        luaL_setfuncs(L, common, 0);
+        if (metamethods) luaL_setfuncs(L, metamethods, 0);
+
+        lua_rawsetp(L, LUA_REGISTRYINDEX, ValueKey<T>());
+    }
+
+    template <typename T>
+    inline void RegisterVectorType(lua_State* L, const luaL_Reg* extra) {
+        std::vector<luaL_Reg> methods = {
+            { "Set", l_ValueSet<T> },
+            { "Copy", l_ValueCopy<T> },
+            { "Add", l_VectorArithInPlace<T, OpAdd> },
+            { "Subtract", l_VectorArithInPlace<T, OpSub> },
+            { "Scale", l_VectorArithInPlace<T, OpMul> },
+            { "Multiply", l_VectorArithInPlace<T, OpMul> },
+            { "Divide", l_VectorArithInPlace<T, OpDiv> },
+            { "Normalize", l_VectorNormalizeInPlace<T> },
+            { "Lerp", l_VectorLerpInPlace<T> },
+            { "Dot", l_VectorDot<T> },
+            { "Length", l_VectorLength<T> },
+            { "LengthSqr", l_VectorLengthSqr<T> },
+            { "Distance", l_VectorDistance<T> },
+        };
+        for (const luaL_Reg* reg = extra; reg && reg->name; reg++) methods.push_back(*reg);
+        methods.push_back({ nullptr, nullptr });
+
+        const luaL_Reg metamethods[] = {
+            { "__add", l_VectorArith<T, OpAdd> },
+            { "__sub", l_VectorArith<T, OpSub> },
+            { "__mul", l_VectorArith<T, OpMul> },
+            { "__div", l_VectorArith<T, OpDiv> },
+            { "__unm", l_VectorUnm<T> },
+            { nullptr, nullptr }
+        };
+        RegisterValueType<T>(L, methods.data(), metamethods);
+    }
+
+    inline void RegisterValueTypes(lua_State* L) {
+        const luaL_Reg vector2Extra[] = { { "Rotate", l_Vector2RotateInPlace }, { nullptr, nullptr } };
+        const luaL_Reg vector3Extra[] = { { "Cross", l_Vector3CrossInPlace }, { nullptr, nullptr } };
+        RegisterVectorType<Vector2>(L, vector2Extra);
+        RegisterVectorType<Vector3>(L, vector3Extra);
+
+        const luaL_Reg plain[] = {
+            { "Set", l_ValueSet<Color> },
+            { "Copy", l_ValueCopy<Color> },
+            { nullptr, nullptr }
+        };
+        RegisterValueType<Color>(L, plain, nullptr);
+
+        const luaL_Reg rectangle[] = {
+            { "Set", l_ValueSet<Rectangle> },
+            { "Copy", l_ValueCopy<Rectangle> },
+            { nullptr, nullptr }
+        };
+        RegisterValueType<Rectangle>(L, rectangle, nullptr);
+    }
+
+    // --- Float arrays ---
+    // FloatArray(n) is a fixed-size block of floats owned by Lua, used as the packed input of
+    // the batch draw calls (and anything else that wants numbers without a table per element).
+    // Indices are 1-based like tables.
+    //
+    // A view (PushFloatView) is a FloatArray over engine memory, e.g. a component's fields: reads
+    // and writes go straight to the component. Whoever owns the memory calls ClearFloatView
+    // before it goes away; the view then has no elements.
+
+    struct FloatArray {
+        uint64_t tag;
+        float* data;
+        size_t count;
+    };
+
+    constexpr uint64_t FloatArrayTag = 0x4D52466C74410000ull;
+
+    inline void* FloatArrayKey() {
+        static char key;
+        return &key;
+    }
+
+    inline FloatArray* TestFloatArray(lua_State* L, int stackIndex) {
+        if (lua_type(L, stackIndex) != LUA_TUSERDATA || lua_rawlen(L, stackIndex) < sizeof(FloatArray)) return nullptr;
+        auto* array = static_cast<FloatArray*>(lua_touserdata(L, stackIndex));
+        return array->tag == FloatArrayTag ? array : nullptr;
+    }
+
+    inline FloatArray* CheckFloatArray(lua_State* L, int stackIndex) {
+        FloatArray* array = TestFloatArray(L, stackIndex);
+        if (!array) luaL_argerror(L, stackIndex, "FloatArray expected");
+        return array;
+    }
+
+    // The floats live right behind the header in the same userdata
+    inline FloatArray* PushFloatArray(lua_State* L, size_t count) {
+        auto* array = static_cast<FloatArray*>(lua_newuserdata(L, sizeof(FloatArray) + count * sizeof(float)));
+        array->tag = FloatArrayTag;
+        array->data = reinterpret_cast<float*>(array + 1);
+        array->count = count;
+        std::memset(array->data, 0, count * sizeof(float));
+        lua_rawgetp(L, LUA_REGISTRYINDEX, FloatArrayKey());
+        lua_setmetatable(L, -2);
+        return array;
+    }
+
+    inline FloatArray* PushFloatView(lua_State* L, float* data, size_t count) {
+        auto* array = static_cast<FloatArray*>(lua_newuserdata(L, sizeof(FloatArray)));
+        array->tag = FloatArrayTag;
+        array->data = data;
+        array->count = count;
+        lua_rawgetp(L, LUA_REGISTRYINDEX, FloatArrayKey());
+        lua_setmetatable(L, -2);
+        return array;
+    }
+
+    inline void ClearFloatView(FloatArray* view) {
+        view->data = nullptr;
+        view->count = 0;
+    }
+
+    inline int l_FloatArrayNew(lua_State* L) {
+        lua_Integer count = luaL_checkinteger(L, 1);
+        luaL_argcheck(L, count >= 0, 1, "negative size");
+        PushFloatArray(L, (size_t)count);
+        return 1;
+    }
+
+    // __index: numbers read elements (nil out of range), strings look up the methods (upvalue 1)
+    inline int l_FloatArrayIndex(lua_State* L) {
+        FloatArray* array = static_cast<FloatArray*>(lua_touserdata(L, 1));
+        if (lua_type(L, 2) == LUA_TNUMBER) {
+            lua_Integer i = lua_tointeger(L, 2);
+            if (i >= 1 && (size_t)i <= array->count) lua_pushnumber(L, array->data[i - 1]);
+            else lua_pushnil(L);
+            return 1;
+        }
+        lua_pushvalue(L, 2);
+        lua_rawget(L, lua_upvalueindex(1));
+        return 1;
+    }
+
+    inline int l_FloatArrayNewIndex(lua_State* L) {
+        FloatArray* array = static_cast<FloatArray*>(lua_touserdata(L, 1));
+        lua_Integer i = luaL_checkinteger(L, 2);
+        luaL_argcheck(L, i >= 1 && (size_t)i <= array->count, 2, "index out of range");
+        array->data[i - 1] = (float)luaL_checknumber(L, 3);
+        return 0;
+    }
+
+    inline int l_FloatArrayLen(lua_State* L) {
+        lua_pushinteger(L, (lua_Integer)static_cast<FloatArray*>(lua_touserdata(L, 1))->count);
+        return 1;
+    }
+
+    // Fill(value [, first, last])
+    inline int l_FloatArrayFill(lua_State* L) {
+        FloatArray* array = CheckFloatArray(L, 1);
+        float value = (float)luaL_checknumber(L, 2);
+        lua_Integer first = luaL_optinteger(L, 3, 1);
+        lua_Integer last = luaL_optinteger(L, 4, (lua_Integer)array->count);
+        if (first < 1) first = 1;
+        if (last > (lua_Integer)array->count) last = (lua_Integer)array->count;
+        for (lua_Integer i = first; i <= last; i++) array->data[i - 1] = value;
+        lua_settop(L, 1);
+        return 1;
+    }
+
+    // Set(i, a, b, c, ...): writes the values to i, i + 1, ... (one call per batch instance)
+    inline int l_FloatArraySet(lua_State* L) {
+        FloatArray* array = CheckFloatArray(L, 1);
+        lua_Integer i = luaL_checkinteger(L, 2);
+        int values = lua_gettop(L) - 2;
+        luaL_argcheck(L, i >= 1 && (size_t)(i - 1 + values) <= array->count, 2, "index out of range");
+        for (int v = 0; v < values; v++) array->data[i - 1 + v] = (float)luaL_checknumber(L, 3 + v);
+        lua_settop(L, 1);
+        return 1;
+    }
+
+    inline void RegisterFloatArray(lua_State* L) {
+        luaL_newmetatable(L, "FloatArray");
+
+        const luaL_Reg methods[] = {
+            { "Fill", l_FloatArrayFill },
+            { "Set", l_FloatArraySet },
+            { nullptr, nullptr }
+        };
+        lua_newtable(L);
+        luaL_setfuncs(L, methods, 0);
+        lua_pushcclosure(L, l_FloatArrayIndex, 1);
+        lua_setfield(L, -2, "__index");
+
+        const luaL_Reg metamethods[] = {
+            { "__newindex", l_FloatArrayNewIndex },
+            { "__len", l_FloatArrayLen },
+            { nullptr, nullptr }
+        };
+        luaL_setfuncs(L, metamethods, 0);
+
+        lua_rawsetp(L, LUA_REGISTRYINDEX, FloatArrayKey());
+    }
+
+    // Floats of a FloatArray (no copy) or a packed { 1, 2, 3, ... } table (copied into scratch)
+    inline const float* GetFloatsFromLua(lua_State* L, int stackIndex, size_t& count, std::vector<float>& scratch) {
+        if (FloatArray* array = TestFloatArray(L, stackIndex)) {
+            count = array->count;
+            return array->data;
+        }
+        luaL_checktype(L, stackIndex, LUA_TTABLE);
+        count = lua_rawlen(L, stackIndex);
+        scratch.resize(count);
+        for (size_t i = 0; i < count; i++) {
+            lua_rawgeti(L, stackIndex, (lua_Integer)i + 1);
+            scratch[i] = (float)lua_tonumber(L, -1);
+            lua_pop(L, 1);
+        }
+        return scratch.data();
+    }
+
+    // --- Color arrays ---
+    // ColorArray(n) holds n packed colors, one uint32 each: the per-instance colors of the batch
+    // draw calls without the 4 floats per instance a FloatArray needs. Elements read as packed
+    // integers; Set and Fill take anything GetColorFromLua does.
+
+    struct ColorArray {
+        uint64_t tag;
+        size_t count;
+        uint32_t* Data() { return reinterpret_cast<uint32_t*>(this + 1); }
+    };
+
+    constexpr uint64_t ColorArrayTag = 0x4D52436F6C410000ull;
+
+    inline void* ColorArrayKey() {
+        static char key;
+        return &key;
+    }
+
+    inline ColorArray* TestColorArray(lua_State* L, int stackIndex) {
+        if (lua_type(L, stackIndex) != LUA_TUSERDATA || lua_rawlen(L, stackIndex) < sizeof(ColorArray)) return nullptr;
+        auto* array = static_cast<ColorArray*>(lua_touserdata(L, stackIndex));
+        return array->tag == ColorArrayTag ? array : nullptr;
+    }
+
+    inline ColorArray* CheckColorArray(lua_State* L, int stackIndex) {
+        ColorArray* array = TestColorArray(L, stackIndex);
+        if (!array) luaL_argerror(L, stackIndex, "ColorArray expected");
+        return array;
+    }
+
+    inline int l_ColorArrayNew(lua_State* L) {
+        lua_Integer count = luaL_checkinteger(L, 1);
+        luaL_argcheck(L, count >= 0, 1, "negative size");
+        auto* array = static_cast<ColorArray*>(lua_newuserdata(L, sizeof(ColorArray) + (size_t)count * sizeof(uint32_t)));
+        array->tag = ColorArrayTag;
+        array->count = (size_t)count;
+        std::memset(array->Data(), 0, (size_t)count * sizeof(uint32_t));
+        lua_rawgetp(L, LUA_REGISTRYINDEX, ColorArrayKey());
+        lua_setmetatable(L, -2);
+        return 1;
+    }
+
+    // __index: numbers read elements (nil out of range), strings look up the methods (upvalue 1)
+    inline int l_ColorArrayIndex(lua_State* L) {
+        ColorArray* array = static_cast<ColorArray*>(lua_touserdata(L, 1));
+        if (lua_type(L, 2) == LUA_TNUMBER) {
+            lua_Integer i = lua_tointeger(L, 2);
+            if (i >= 1 && (size_t)i <= array->count) lua_pushinteger(L, array->Data()[i - 1]);
+            else lua_pushnil(L);
+            return 1;
+        }
+        lua_pushvalue(L, 2);
+        lua_rawget(L, lua_upvalueindex(1));
+        return 1;
+    }
+
+    inline int l_ColorArrayNewIndex(lua_State* L) {
+        ColorArray* array = static_cast<ColorArray*>(lua_touserdata(L, 1));
+        lua_Integer i = luaL_checkinteger(L, 2);
+        luaL_argcheck(L, i >= 1 && (size_t)i <= array->count, 2, "index out of range");
+        array->Data()[i - 1] = ColorBits(GetColorFromLua(L, 3));
+        return 0;
+    }
+
+    inline int l_ColorArrayLen(lua_State* L) {
+        lua_pushinteger(L, (lua_Integer)static_cast<ColorArray*>(lua_touserdata(L, 1))->count);
+        return 1;
+    }
+
+    // Fill(color [, first, last])
+    inline int l_ColorArrayFill(lua_State* L) {
+        ColorArray* array = CheckColorArray(L, 1);
+        uint32_t value = ColorBits(GetColorFromLua(L, 2));
+        lua_Integer first = luaL_optinteger(L, 3, 1);
+        lua_Integer last = luaL_optinteger(L, 4, (lua_Integer)array->count);
+        if (first < 1) first = 1;
+        if (last > (lua_Integer)array->count) last = (lua_Integer)array->count;
+        for (lua_Integer i = first; i <= last; i++) array->Data()[i - 1] = value;
+        lua_settop(L, 1);
+        return 1;
+    }
+
+    // Set(i, a, b, ...): writes the colors to i, i + 1, ...
+    inline int l_ColorArraySet(lua_State* L) {
+        ColorArray* array = CheckColorArray(L, 1);
+        lua_Integer i = luaL_checkinteger(L, 2);
+        int values = lua_gettop(L) - 2;
+        luaL_argcheck(L, i >= 1 && (size_t)(i - 1 + values) <= array->count, 2, "index out of range");
+        for (int v = 0; v < values; v++) array->Data()[i - 1 + v] = ColorBits(GetColorFromLua(L, 3 + v));
+        lua_settop(L, 1);
+        return 1;
+    }
+
+    inline void RegisterColorArray(lua_State* L) {
+        luaL_newmetatable(L, "ColorArray");
+
+        const luaL_Reg methods[] = {
+            { "Fill", l_ColorArrayFill },
+            { "Set", l_ColorArraySet },
+            { nullptr, nullptr }
+        };
+        lua_newtable(L);
+        luaL_setfuncs(L, methods, 0);
+        lua_pushcclosure(L, l_ColorArrayIndex, 1);
+        lua_setfield(L, -2, "__index");
+
+        const luaL_Reg metamethods[] = {
+            { "__newindex", l_ColorArrayNewIndex },
+            { "__len", l_ColorArrayLen },
+            { nullptr, nullptr }
+        };
+        luaL_setfuncs(L, metamethods, 0);
+
+        lua_rawsetp(L, LUA_REGISTRYINDEX, ColorArrayKey());
+    }
+
+    // Converts r, g, b, a float quadruples to packed colors. No branches or calls in the loop,
+    // so the compiler vectorizes it.
+    inline void PackColorComponents(const float* components, size_t count, uint32_t* out) {
+        for (size_t i = 0; i < count; i++) {
+            const float* c = components + i * 4;
+            out[i] = ((uint32_t)(int)c[0] & 0xFF) << 24 | ((uint32_t)(int)c[1] & 0xFF) << 16 |
+                     ((uint32_t)(int)c[2] & 0xFF) << 8 | ((uint32_t)(int)c[3] & 0xFF);
+        }
+    }
+
+    // --- Textures ---
+    // LoadTexture returns a Texture userdata holding one reference on the AssetCache entry.
+    // __gc (or UnloadTexture) drops it, the cache unloads the texture once nothing uses it.
+    // Fields: id, width, height, mipmaps, format (also [1] to [5], like the old return values).
+
+    struct LuaTexture {
+        uint64_t tag;
+        Texture2D texture;
+    };
+
+    constexpr uint64_t TextureTag = 0x4D52546578740000ull;
+
+    inline void* TextureKey() {
+        static char key;
+        return &key;
+    }
+
+    inline LuaTexture* TestTexture(lua_State* L, int stackIndex) {
+        if (lua_type(L, stackIndex) != LUA_TUSERDATA || lua_rawlen(L, stackIndex) < sizeof(LuaTexture)) return nullptr;
+        auto* texture = static_cast<LuaTexture*>(lua_touserdata(L, stackIndex));
+        return texture->tag == TextureTag ? texture : nullptr;
+    }
+
+    // Takes ownership of one AssetCache reference
+    inline void PushTexture(lua_State* L, Texture2D texture) {
+        auto* handle = static_cast<LuaTexture*>(lua_newuserdata(L, sizeof(LuaTexture)));
+        handle->tag = TextureTag;
+        handle->texture = texture;
+        lua_rawgetp(L, LUA_REGISTRYINDEX, TextureKey());
+        lua_setmetatable(L, -2);
+    }
+
+    inline void ReleaseTexture(LuaTexture* handle) {
+        if (handle->texture.id != 0) AssetCache::Get().ReleaseTexture(handle->texture.id);
+        handle->texture = { 0 };
+    }
+
+    inline int l_TextureIndex(lua_State* L) {
+        const Texture2D& texture = static_cast<LuaTexture*>(lua_touserdata(L, 1))->texture;
+        const int values[] = { (int)texture.id, texture.width, texture.height, texture.mipmaps, texture.format };
+        static const char* const fields[] = { "id", "width", "height", "mipmaps", "format" };
+
+        int field = -1;
+        if (lua_type(L, 2) == LUA_TNUMBER) field = (int)lua_tointeger(L, 2) - 1;
+        else if (const char* name = lua_tostring(L, 2)) {
+            for (int i = 0; i < 5; i++) if (std::strcmp(name, fields[i]) == 0) field = i;
+        }
+        if (field >= 0 && field < 5) lua_pushinteger(L, values[field]);
+        else lua_pushnil(L);
+        return 1;
+    }
+
+    inline int l_TextureGC(lua_State* L) {
+        ReleaseTexture(static_cast<LuaTexture*>(lua_touserdata(L, 1)));
+        return 0;
+    }
+
+    inline int l_TextureToString(lua_State* L) {
+        const Texture2D& texture = static_cast<LuaTexture*>(lua_touserdata(L, 1))->texture;
+        lua_pushfstring(L, "Texture(%d, %dx%d)", (int)texture.id, texture.width, texture.height);
+        return 1;
+    }
+
+    inline void RegisterTexture(lua_State* L) {
+        luaL_newmetatable(L, "Texture");
+        const luaL_Reg metamethods[] = {
+            { "__index", l_TextureIndex },
+            { "__gc", l_TextureGC },
+            { "__tostring", l_TextureToString },
+            { nullptr, nullptr }
+        };
+        luaL_setfuncs(L, metamethods, 0);
+        lua_rawsetp(L, LUA_REGISTRYINDEX, TextureKey());
+    }
+
+    // A Texture, or the old forms: { id, width, height, mipmaps, format }, the same named
+    // fields, or { texture }
+    inline Texture2D GetTextureFromLua(lua_State* L, int stackIndex) {
+        if (LuaTexture* handle = TestTexture(L, stackIndex)) return handle->texture;
+
+        Texture2D texture = { 0 };
+        luaL_checktype(L, stackIndex, LUA_TTABLE);
+        lua_rawgeti(L, stackIndex, 1);
+        if (LuaTexture* handle = TestTexture(L, -1)) texture = handle->texture;
+        lua_pop(L, 1);
+        if (texture.id != 0) return texture;
+
+        const char* fields[] = { "id", "width", "height", "mipmaps", "format" };
+        int values[5];
+        for (int i = 0; i < 5; i++) {
+            if (lua_rawgeti(L, stackIndex, i + 1) == LUA_TNIL) {
+                lua_pop(L, 1);
+                lua_getfield(L, stackIndex, fields[i]);
+            }
+            values[i] = (int)lua_tointeger(L, -1);
+            lua_pop(L, 1);
+        }
+        texture.id = (unsigned int)values[0];
+        texture.width = values[1];
+        texture.height = values[2];
+        texture.mipmaps = values[3];
+        texture.format = values[4];
+        return texture;
+    }
+
+    // Texture argument of DrawTexture and friends: a Texture, or the five integers LoadTexture
+    // used to return. Returns the index of the next argument.
+    inline int GetTextureArgs(lua_State* L, int stackIndex, Texture2D& texture) {
+        if (LuaTexture* handle = TestTexture(L, stackIndex)) {
+            texture = handle->texture;
+            return stackIndex + 1;
+        }
+        texture.id = (unsigned int)luaL_checkinteger(L, stackIndex);
+        texture.width = (int)luaL_checkinteger(L, stackIndex + 1);
+        texture.height = (int)luaL_checkinteger(L, stackIndex + 2);
+        texture.mipmaps = (int)luaL_checkinteger(L, stackIndex + 3);
+        texture.format = (int)luaL_checkinteger(L, stackIndex + 4);
+        return stackIndex + 5;
+    }
+
+    // --- Batched primitives ---
+    // One packet for the whole batch: the data argument is read once, the render thread emits
+    // the vertices straight into rlgl instead of going through one raylib call per shape.
+    //
+    // color: a Color (or { r, g, b, a }, or a packed integer) for the whole batch, a ColorArray
+    // with a color per instance, or an array with 4 numbers (r, g, b, a) per instance. count
+    // defaults to as many instances as the data holds.
+
+    inline int SubmitBatch(lua_State* L, DrawPacket& packet, int dataIndex, int colorIndex, int countIndex) {
+        static thread_local std::vector<float> input;
+        static thread_local std::vector<float> colors;
+        static thread_local std::vector<uint32_t> colorBits;
+        static thread_local std::vector<float> packed;
+
+        const int stride = BatchStride(packet.command);
+        size_t valueCount = 0;
+        const float* values = GetFloatsFromLua(L, dataIndex, valueCount, input);
+
+        size_t count = valueCount / stride;
+        if (!lua_isnoneornil(L, countIndex)) {
+            lua_Integer requested = luaL_checkinteger(L, countIndex);
+            luaL_argcheck(L, requested >= 0, countIndex, "negative count");
+            count = std::min(count, (size_t)requested);
+        }
+
+        const uint32_t* instanceColors = nullptr;
+        if (lua_isnoneornil(L, colorIndex)) {
+            packet.color = WHITE;
+        } else if (lua_isinteger(L, colorIndex) || TestValue<Color>(L, colorIndex) ||
+                   (lua_istable(L, colorIndex) && lua_rawlen(L, colorIndex) == 4)) {
+            packet.color = GetColorFromLua(L, colorIndex);
+        } else if (ColorArray* array = TestColorArray(L, colorIndex)) {
+            instanceColors = array->Data();
+            count = std::min(count, array->count);
+        } else {
+            size_t colorCount = 0;
+            const float* components = GetFloatsFromLua(L, colorIndex, colorCount, colors);
+            count = std::min(count, colorCount / 4);
+            colorBits.resize(count);
+            PackColorComponents(components, count, colorBits.data());
+            instanceColors = colorBits.data();
+        }
+        if (count == 0) return 0;
+
+        packet.count = (uint32_t)count;
+        if (!instanceColors) {
+            SubmitDraw(packet, nullptr, values, count * stride);
+            return 0;
+        }
+
+        packet.instanceColors = true;
+        packed.resize(count * (stride + 1));
+        float* out = packed.data();
+        for (size_t i = 0; i < count; i++) {
+            std::memcpy(out, values + i * stride, stride * sizeof(float));
+            std::memcpy(out + stride, instanceColors + i, sizeof(uint32_t));
+            out += stride + 1;
+        }
+        SubmitDraw(packet, nullptr, packed.data(), packed.size());
+        return 0;
+    }
+
+    // DrawCirclesBatch(data, color [, count]), data = x, y, radius per circle
+    inline int l_DrawCirclesBatch(lua_State* L) {
+        DrawPacket packet;
+        packet.command = DrawCommand::CircleBatch;
+        return SubmitBatch(L, packet, 1, 2, 3);
+    }
+
+    // DrawRectanglesBatch(data, color [, count]), data = x, y, width, height per rectangle
+    inline int l_DrawRectanglesBatch(lua_State* L) {
+        DrawPacket packet;
+        packet.command = DrawCommand::RectangleBatch;
+        return SubmitBatch(L, packet, 1, 2, 3);
+    }
+
+    // DrawSpritesBatch(texture, data, tint [, count]), data = x, y, rotation, scale per sprite
+    inline int l_DrawSpritesBatch(lua_State* L) {
+        DrawPacket packet;
+        packet.command = DrawCommand::SpriteBatch;
+        packet.texture = GetTextureFromLua(L, 1);
+        return SubmitBatch(L, packet, 2, 3, 4);
     }
 
     
@@ -102,13 +1060,13 @@ namespace MoonRay {
     inline int l_InitWindow(lua_State* L) {
         int width = (int)luaL_checkinteger(L, 1);
         int height = (int)luaL_checkinteger(L, 2);
-        const char* title = luaL_checkstring(L, 3);
-        InitWindow(width, height, title);
+        std::string title = luaL_checkstring(L, 3);
+        RunOnMainThread([=] { InitWindow(width, height, title.c_str()); });
         return 0;
     }
 
     inline int l_CloseWindow(lua_State* L) {
-        CloseWindow();
+        RunOnMainThread([] { CloseWindow(); });
         return 0;
     }
 
@@ -119,24 +1077,24 @@ namespace MoonRay {
 
     inline int l_SetTargetFPS(lua_State* L) {
         int fps = (int)luaL_checkinteger(L, 1);
-        SetTargetFPS(fps);
+        RunOnMainThread([=] { SetTargetFPS(fps); });
         return 0;
     }
 
     
     inline int l_BeginDrawing(lua_State* L) {
-        BeginDrawing();
+        RunOnMainThread([] { BeginDrawing(); });
         return 0;
     }
 
     inline int l_EndDrawing(lua_State* L) {
-        EndDrawing();
+        RunOnMainThread([] { EndDrawing(); });
         return 0;
     }
 
     inline int l_ClearBackground(lua_State* L) {
         Color col = GetColorFromLua(L, 1);
-        ClearBackground(col);
+        RunOnMainThread([=] { ClearBackground(col); });
         return 0;
     }
 
@@ -147,7 +1105,12 @@ namespace MoonRay {
         int y = (int)luaL_checkinteger(L, 3);
         int fontSize = (int)luaL_checkinteger(L, 4);
         Color col = GetColorFromLua(L, 5);
-        DrawText(text, x, y, fontSize, col);
+        DrawPacket packet;
+        packet.command = DrawCommand::Text;
+        packet.position = { (float)x, (float)y, 0.0f };
+        packet.size.x = (float)fontSize;
+        packet.color = col;
+        SubmitDraw(packet, text);
         return 0;
     }
 
@@ -157,7 +1120,12 @@ namespace MoonRay {
         int width = (int)luaL_checkinteger(L, 3);
         int height = (int)luaL_checkinteger(L, 4);
         Color col = GetColorFromLua(L, 5);
-        DrawRectangle(x, y, width, height, col);
+        DrawPacket packet;
+        packet.command = DrawCommand::Rectangle;
+        packet.position = { (float)x, (float)y, 0.0f };
+        packet.size = { (float)width, (float)height, 0.0f };
+        packet.color = col;
+        SubmitDraw(packet);
         return 0;
     }
 
@@ -167,7 +1135,12 @@ namespace MoonRay {
         int width = (int)luaL_checkinteger(L, 3);
         int height = (int)luaL_checkinteger(L, 4);
         Color col = GetColorFromLua(L, 5);
-        DrawRectangleLines(x, y, width, height, col);
+        DrawPacket packet;
+        packet.command = DrawCommand::RectangleLines;
+        packet.position = { (float)x, (float)y, 0.0f };
+        packet.size = { (float)width, (float)height, 0.0f };
+        packet.color = col;
+        SubmitDraw(packet);
         return 0;
     }
 
@@ -176,7 +1149,12 @@ namespace MoonRay {
         int centerY = (int)luaL_checkinteger(L, 2);
         float radius = (float)luaL_checknumber(L, 3);
         Color col = GetColorFromLua(L, 4);
-        DrawCircle(centerX, centerY, radius, col);
+        DrawPacket packet;
+        packet.command = DrawCommand::Circle;
+        packet.position = { (float)centerX, (float)centerY, 0.0f };
+        packet.size.x = radius;
+        packet.color = col;
+        SubmitDraw(packet);
         return 0;
     }
 
@@ -185,7 +1163,12 @@ namespace MoonRay {
         int centerY = (int)luaL_checkinteger(L, 2);
         float radius = (float)luaL_checknumber(L, 3);
         Color col = GetColorFromLua(L, 4);
-        DrawCircleLines(centerX, centerY, radius, col);
+        DrawPacket packet;
+        packet.command = DrawCommand::CircleLines;
+        packet.position = { (float)centerX, (float)centerY, 0.0f };
+        packet.size.x = radius;
+        packet.color = col;
+        SubmitDraw(packet);
         return 0;
     }
 
@@ -195,7 +1178,12 @@ namespace MoonRay {
         int endX = (int)luaL_checkinteger(L, 3);
         int endY = (int)luaL_checkinteger(L, 4);
         Color col = GetColorFromLua(L, 5);
-        DrawLine(startX, startY, endX, endY, col);
+        DrawPacket packet;
+        packet.command = DrawCommand::Line;
+        packet.position = { (float)startX, (float)startY, 0.0f };
+        packet.size = { (float)endX, (float)endY, 0.0f };
+        packet.color = col;
+        SubmitDraw(packet);
         return 0;
     }
 
@@ -203,7 +1191,11 @@ namespace MoonRay {
         int x = (int)luaL_checkinteger(L, 1);
         int y = (int)luaL_checkinteger(L, 2);
         Color col = GetColorFromLua(L, 3);
-        DrawPixel(x, y, col);
+        DrawPacket packet;
+        packet.command = DrawCommand::Pixel;
+        packet.position = { (float)x, (float)y, 0.0f };
+        packet.color = col;
+        SubmitDraw(packet);
         return 0;
     }
 
@@ -214,7 +1206,12 @@ namespace MoonRay {
         float height = (float)luaL_checknumber(L, 3);
         float length = (float)luaL_checknumber(L, 4);
         Color col = GetColorFromLua(L, 5);
-        DrawCube(pos, width, height, length, col);
+        DrawPacket packet;
+        packet.command = DrawCommand::Cube;
+        packet.position = pos;
+        packet.size = { width, height, length };
+        packet.color = col;
+        SubmitDraw(packet);
         return 0;
     }
 
@@ -224,7 +1221,12 @@ namespace MoonRay {
         float height = (float)luaL_checknumber(L, 3);
         float length = (float)luaL_checknumber(L, 4);
         Color col = GetColorFromLua(L, 5);
-        DrawCubeWires(pos, width, height, length, col);
+        DrawPacket packet;
+        packet.command = DrawCommand::CubeWires;
+        packet.position = pos;
+        packet.size = { width, height, length };
+        packet.color = col;
+        SubmitDraw(packet);
         return 0;
     }
 
@@ -232,7 +1234,12 @@ namespace MoonRay {
         Vector3 center = GetVector3FromLua(L, 1);
         float radius = (float)luaL_checknumber(L, 2);
         Color col = GetColorFromLua(L, 3);
-        DrawSphere(center, radius, col);
+        DrawPacket packet;
+        packet.command = DrawCommand::Sphere;
+        packet.position = center;
+        packet.size.x = radius;
+        packet.color = col;
+        SubmitDraw(packet);
         return 0;
     }
 
@@ -242,14 +1249,22 @@ namespace MoonRay {
         int rings = (int)luaL_checkinteger(L, 3);
         int slices = (int)luaL_checkinteger(L, 4);
         Color col = GetColorFromLua(L, 5);
-        DrawSphereWires(center, radius, rings, slices, col);
+        DrawPacket packet;
+        packet.command = DrawCommand::SphereWires;
+        packet.position = center;
+        packet.size = { radius, (float)rings, (float)slices };
+        packet.color = col;
+        SubmitDraw(packet);
         return 0;
     }
 
     inline int l_DrawGrid(lua_State* L) {
         int slices = (int)luaL_checkinteger(L, 1);
         float spacing = (float)luaL_checknumber(L, 2);
-        DrawGrid(slices, spacing);
+        DrawPacket packet;
+        packet.command = DrawCommand::Grid;
+        packet.size = { (float)slices, spacing, 0.0f };
+        SubmitDraw(packet);
         return 0;
     }
 
@@ -261,12 +1276,12 @@ namespace MoonRay {
         camera.up = GetVector3FromLua(L, 3);
         camera.fovy = (float)luaL_checknumber(L, 4);
         camera.projection = (int)luaL_checkinteger(L, 5);
-        BeginMode3D(camera);
+        RunOnMainThread([=] { BeginMode3D(camera); });
         return 0;
     }
 
     inline int l_EndMode3D(lua_State* L) {
-        EndMode3D();
+        RunOnMainThread([] { EndMode3D(); });
         return 0;
     }
 
@@ -276,12 +1291,12 @@ namespace MoonRay {
         camera.target = GetVector2FromLua(L, 2);
         camera.rotation = (float)luaL_checknumber(L, 3);
         camera.zoom = (float)luaL_checknumber(L, 4);
-        BeginMode2D(camera);
+        RunOnMainThread([=] { BeginMode2D(camera); });
         return 0;
     }
 
     inline int l_EndMode2D(lua_State* L) {
-        EndMode2D();
+        RunOnMainThread([] { EndMode2D(); });
         return 0;
     }
 
@@ -307,30 +1322,41 @@ namespace MoonRay {
     }
 
     
+    // The input functions read the frame's InputSnapshot once the engine captures one, raylib
+    // before that (or when the host never does)
+    inline const InputSnapshot* CapturedInput() {
+        return InputSnapshot::Captured() ? &InputSnapshot::Current() : nullptr;
+    }
+
     inline int l_IsKeyDown(lua_State* L) {
         int key = (int)luaL_checkinteger(L, 1);
-        lua_pushboolean(L, IsKeyDown(key));
+        const InputSnapshot* input = CapturedInput();
+        lua_pushboolean(L, input ? input->KeyDown(key) : IsKeyDown(key));
         return 1;
     }
 
     inline int l_IsKeyPressed(lua_State* L) {
         int key = (int)luaL_checkinteger(L, 1);
-        lua_pushboolean(L, IsKeyPressed(key));
+        const InputSnapshot* input = CapturedInput();
+        lua_pushboolean(L, input ? input->KeyPressed(key) : IsKeyPressed(key));
         return 1;
     }
 
     inline int l_IsKeyReleased(lua_State* L) {
         int key = (int)luaL_checkinteger(L, 1);
-        lua_pushboolean(L, IsKeyReleased(key));
+        const InputSnapshot* input = CapturedInput();
+        lua_pushboolean(L, input ? input->KeyReleased(key) : IsKeyReleased(key));
         return 1;
     }
 
     inline int l_IsKeyUp(lua_State* L) {
         int key = (int)luaL_checkinteger(L, 1);
-        lua_pushboolean(L, IsKeyUp(key));
+        const InputSnapshot* input = CapturedInput();
+        lua_pushboolean(L, input ? !input->KeyDown(key) : IsKeyUp(key));
         return 1;
     }
 
+    // Key and char queues are consumed by the call, they stay with raylib
     inline int l_GetKeyPressed(lua_State* L) {
         lua_pushinteger(L, GetKeyPressed());
         return 1;
@@ -343,53 +1369,150 @@ namespace MoonRay {
 
     
     inline int l_GetMouseX(lua_State* L) {
-        lua_pushinteger(L, GetMouseX());
+        const InputSnapshot* input = CapturedInput();
+        lua_pushinteger(L, input ? (int)input->mousePosition.x : GetMouseX());
         return 1;
     }
 
     inline int l_GetMouseY(lua_State* L) {
-        lua_pushinteger(L, GetMouseY());
+        const InputSnapshot* input = CapturedInput();
+        lua_pushinteger(L, input ? (int)input->mousePosition.y : GetMouseY());
         return 1;
     }
 
+    // GetMousePosition([out]): writes into out (a Vector2) instead of allocating one
     inline int l_GetMousePosition(lua_State* L) {
-        Vector2 pos = GetMousePosition();
-        PushVector2ToLua(L, pos);
+        const InputSnapshot* input = CapturedInput();
+        PushResult(L, input ? input->mousePosition : GetMousePosition(), 1);
         return 1;
     }
 
     inline int l_GetMouseDelta(lua_State* L) {
-        Vector2 delta = GetMouseDelta();
-        PushVector2ToLua(L, delta);
+        const InputSnapshot* input = CapturedInput();
+        PushResult(L, input ? input->mouseDelta : GetMouseDelta(), 1);
         return 1;
     }
 
     inline int l_GetMouseWheelMove(lua_State* L) {
-        lua_pushnumber(L, GetMouseWheelMove());
+        const InputSnapshot* input = CapturedInput();
+        lua_pushnumber(L, input ? input->mouseWheel : GetMouseWheelMove());
         return 1;
     }
 
     inline int l_IsMouseButtonDown(lua_State* L) {
         int button = (int)luaL_checkinteger(L, 1);
-        lua_pushboolean(L, IsMouseButtonDown(button));
+        const InputSnapshot* input = CapturedInput();
+        lua_pushboolean(L, input ? input->MouseDown(button) : IsMouseButtonDown(button));
         return 1;
     }
 
     inline int l_IsMouseButtonPressed(lua_State* L) {
         int button = (int)luaL_checkinteger(L, 1);
-        lua_pushboolean(L, IsMouseButtonPressed(button));
+        const InputSnapshot* input = CapturedInput();
+        lua_pushboolean(L, input ? input->MousePressed(button) : IsMouseButtonPressed(button));
         return 1;
     }
 
     inline int l_IsMouseButtonReleased(lua_State* L) {
         int button = (int)luaL_checkinteger(L, 1);
-        lua_pushboolean(L, IsMouseButtonReleased(button));
+        const InputSnapshot* input = CapturedInput();
+        lua_pushboolean(L, input ? input->MouseReleased(button) : IsMouseButtonReleased(button));
         return 1;
     }
 
     inline int l_IsMouseButtonUp(lua_State* L) {
         int button = (int)luaL_checkinteger(L, 1);
-        lua_pushboolean(L, IsMouseButtonUp(button));
+        const InputSnapshot* input = CapturedInput();
+        lua_pushboolean(L, input ? !input->MouseDown(button) : IsMouseButtonUp(button));
+        return 1;
+    }
+
+    // --- Input snapshot ---
+    // `Input` is a read-only userdata over InputSnapshot::Current(). Fields: mouseX, mouseY,
+    // mouseDeltaX, mouseDeltaY, mouseWheel, frame. Methods: KeyDown(key), KeyPressed,
+    // KeyReleased, MouseDown(button), MousePressed, MouseReleased, GamepadAvailable(gamepad),
+    // GamepadDown(gamepad, button), GamepadAxis(gamepad, axis); gamepads count from 0 like raylib.
+    // Reading a field costs one table lookup and no raylib call or allocation.
+
+    enum InputField { InputMouseX, InputMouseY, InputMouseDeltaX, InputMouseDeltaY, InputMouseWheel, InputFrame };
+
+    inline int l_InputKeyDown(lua_State* L) { lua_pushboolean(L, InputSnapshot::Current().KeyDown((int)luaL_checkinteger(L, 2))); return 1; }
+    inline int l_InputKeyPressed(lua_State* L) { lua_pushboolean(L, InputSnapshot::Current().KeyPressed((int)luaL_checkinteger(L, 2))); return 1; }
+    inline int l_InputKeyReleased(lua_State* L) { lua_pushboolean(L, InputSnapshot::Current().KeyReleased((int)luaL_checkinteger(L, 2))); return 1; }
+    inline int l_InputMouseDown(lua_State* L) { lua_pushboolean(L, InputSnapshot::Current().MouseDown((int)luaL_checkinteger(L, 2))); return 1; }
+    inline int l_InputMousePressed(lua_State* L) { lua_pushboolean(L, InputSnapshot::Current().MousePressed((int)luaL_checkinteger(L, 2))); return 1; }
+    inline int l_InputMouseReleased(lua_State* L) { lua_pushboolean(L, InputSnapshot::Current().MouseReleased((int)luaL_checkinteger(L, 2))); return 1; }
+    inline int l_InputGamepadAvailable(lua_State* L) { lua_pushboolean(L, InputSnapshot::Current().GamepadAvailable((int)luaL_checkinteger(L, 2))); return 1; }
+
+    inline int l_InputGamepadDown(lua_State* L) {
+        lua_pushboolean(L, InputSnapshot::Current().GamepadDown((int)luaL_checkinteger(L, 2), (int)luaL_checkinteger(L, 3)));
+        return 1;
+    }
+
+    inline int l_InputGamepadAxis(lua_State* L) {
+        lua_pushnumber(L, InputSnapshot::Current().GamepadAxis((int)luaL_checkinteger(L, 2), (int)luaL_checkinteger(L, 3)));
+        return 1;
+    }
+
+    // __index: upvalue 1 maps names to methods or InputField numbers
+    inline int l_InputIndex(lua_State* L) {
+        lua_pushvalue(L, 2);
+        if (lua_rawget(L, lua_upvalueindex(1)) != LUA_TNUMBER) return 1;
+
+        const InputSnapshot& input = InputSnapshot::Current();
+        switch (lua_tointeger(L, -1)) {
+            case InputMouseX: lua_pushnumber(L, input.mousePosition.x); break;
+            case InputMouseY: lua_pushnumber(L, input.mousePosition.y); break;
+            case InputMouseDeltaX: lua_pushnumber(L, input.mouseDelta.x); break;
+            case InputMouseDeltaY: lua_pushnumber(L, input.mouseDelta.y); break;
+            case InputMouseWheel: lua_pushnumber(L, input.mouseWheel); break;
+            default: lua_pushinteger(L, (lua_Integer)input.frame); break;
+        }
+        return 1;
+    }
+
+    inline int l_InputNewIndex(lua_State* L) {
+        return luaL_error(L, "Input is read-only");
+    }
+
+    // Pushes the Input userdata, creating it on the first call in a state
+    inline int l_PushInput(lua_State* L) {
+        static char key;
+        if (lua_rawgetp(L, LUA_REGISTRYINDEX, &key) != LUA_TNIL) return 1;
+        lua_pop(L, 1);
+
+        lua_newuserdata(L, 1);
+        lua_createtable(L, 0, 3);
+
+        const luaL_Reg methods[] = {
+            { "KeyDown", l_InputKeyDown },
+            { "KeyPressed", l_InputKeyPressed },
+            { "KeyReleased", l_InputKeyReleased },
+            { "MouseDown", l_InputMouseDown },
+            { "MousePressed", l_InputMousePressed },
+            { "MouseReleased", l_InputMouseReleased },
+            { "GamepadAvailable", l_InputGamepadAvailable },
+            { "GamepadDown", l_InputGamepadDown },
+            { "GamepadAxis", l_InputGamepadAxis },
+            { nullptr, nullptr }
+        };
+        lua_newtable(L);
+        luaL_setfuncs(L, methods, 0);
+        const char* fields[] = { "mouseX", "mouseY", "mouseDeltaX", "mouseDeltaY", "mouseWheel", "frame" };
+        for (int i = 0; i < 6; i++) {
+            lua_pushinteger(L, i);
+            lua_setfield(L, -2, fields[i]);
+        }
+        lua_pushcclosure(L, l_InputIndex, 1);
+        lua_setfield(L, -2, "__index");
+        lua_pushcfunction(L, l_InputNewIndex);
+        lua_setfield(L, -2, "__newindex");
+        lua_pushliteral(L, "Input");
+        lua_setfield(L, -2, "__name");
+        lua_setmetatable(L, -2);
+
+        lua_pushvalue(L, -1);
+        lua_rawsetp(L, LUA_REGISTRYINDEX, &key);
         return 1;
     }
 
@@ -414,7 +1537,7 @@ namespace MoonRay {
         Vector2 v1 = GetVector2FromLua(L, 1);
         Vector2 v2 = GetVector2FromLua(L, 2);
         Vector2 result = Vector2Add(v1, v2);
-        PushVector2ToLua(L, result);
+        PushResult(L, result, 3);
         return 1;
     }
 
@@ -422,7 +1545,7 @@ namespace MoonRay {
         Vector2 v1 = GetVector2FromLua(L, 1);
         Vector2 v2 = GetVector2FromLua(L, 2);
         Vector2 result = Vector2Subtract(v1, v2);
-        PushVector2ToLua(L, result);
+        PushResult(L, result, 3);
         return 1;
     }
 
@@ -430,7 +1553,7 @@ namespace MoonRay {
         Vector2 v = GetVector2FromLua(L, 1);
         float scale = (float)luaL_checknumber(L, 2);
         Vector2 result = Vector2Scale(v, scale);
-        PushVector2ToLua(L, result);
+        PushResult(L, result, 3);
         return 1;
     }
 
@@ -464,7 +1587,7 @@ namespace MoonRay {
     inline int l_Vector2Normalize(lua_State* L) {
         Vector2 v = GetVector2FromLua(L, 1);
         Vector2 result = Vector2Normalize(v);
-        PushVector2ToLua(L, result);
+        PushResult(L, result, 2);
         return 1;
     }
 
@@ -472,7 +1595,7 @@ namespace MoonRay {
         Vector2 v = GetVector2FromLua(L, 1);
         float angle = (float)luaL_checknumber(L, 2);
         Vector2 result = Vector2Rotate(v, angle);
-        PushVector2ToLua(L, result);
+        PushResult(L, result, 3);
         return 1;
     }
 
@@ -481,7 +1604,7 @@ namespace MoonRay {
         Vector3 v1 = GetVector3FromLua(L, 1);
         Vector3 v2 = GetVector3FromLua(L, 2);
         Vector3 result = Vector3Add(v1, v2);
-        PushVector3ToLua(L, result);
+        PushResult(L, result, 3);
         return 1;
     }
 
@@ -489,7 +1612,7 @@ namespace MoonRay {
         Vector3 v1 = GetVector3FromLua(L, 1);
         Vector3 v2 = GetVector3FromLua(L, 2);
         Vector3 result = Vector3Subtract(v1, v2);
-        PushVector3ToLua(L, result);
+        PushResult(L, result, 3);
         return 1;
     }
 
@@ -497,7 +1620,7 @@ namespace MoonRay {
         Vector3 v = GetVector3FromLua(L, 1);
         float scale = (float)luaL_checknumber(L, 2);
         Vector3 result = Vector3Scale(v, scale);
-        PushVector3ToLua(L, result);
+        PushResult(L, result, 3);
         return 1;
     }
 
@@ -511,14 +1634,14 @@ namespace MoonRay {
         Vector3 v1 = GetVector3FromLua(L, 1);
         Vector3 v2 = GetVector3FromLua(L, 2);
         Vector3 result = Vector3CrossProduct(v1, v2);
-        PushVector3ToLua(L, result);
+        PushResult(L, result, 3);
         return 1;
     }
 
     inline int l_Vector3Normalize(lua_State* L) {
         Vector3 v = GetVector3FromLua(L, 1);
         Vector3 result = Vector3Normalize(v);
-        PushVector3ToLua(L, result);
+        PushResult(L, result, 2);
         return 1;
     }
 
@@ -532,6 +1655,17 @@ namespace MoonRay {
         return 1;
     }
 
+    inline int l_ColorToInt(lua_State* L) {
+        lua_pushinteger(L, (lua_Integer)ColorBits(GetColorFromLua(L, 1)));
+        return 1;
+    }
+
+    // GetColor(0xRRGGBBAA): the Color behind a packed integer
+    inline int l_GetColor(lua_State* L) {
+        PushColorToLua(L, ColorFromBits((uint32_t)luaL_checkinteger(L, 1)));
+        return 1;
+    }
+
     inline int l_ColorAlpha(lua_State* L) {
         Color color = GetColorFromLua(L, 1);
         float alpha = (float)luaL_checknumber(L, 2);
@@ -552,68 +1686,75 @@ namespace MoonRay {
     
     inline int l_LoadTexture(lua_State* L) {
         const char* fileName = luaL_checkstring(L, 1);
-        Texture2D texture = LoadTexture(fileName);
-        lua_pushinteger(L, texture.id);
-        lua_pushinteger(L, texture.width);
-        lua_pushinteger(L, texture.height);
-        lua_pushinteger(L, texture.mipmaps);
-        lua_pushinteger(L, texture.format);
-        return 5;
+        if (OnWorkerThread()) return luaL_error(L, "LoadTexture can't be called from a parallel update, load textures when the script starts");
+        PushTexture(L, AssetCache::Get().AcquireTexture(fileName));
+        return 1;
     }
 
+    // UnloadTexture(texture) drops the reference now instead of at collection
     inline int l_UnloadTexture(lua_State* L) {
+        if (LuaTexture* handle = TestTexture(L, 1)) {
+            ReleaseTexture(handle);
+            return 0;
+        }
+        // The old integer form: a cached id drops one reference (like the Texture's __gc would),
+        // only ids the cache doesn't know are unloaded right away
         Texture2D texture;
-        texture.id = (unsigned int)luaL_checkinteger(L, 1);
-        texture.width = (int)luaL_checkinteger(L, 2);
-        texture.height = (int)luaL_checkinteger(L, 3);
-        texture.mipmaps = (int)luaL_checkinteger(L, 4);
-        texture.format = (int)luaL_checkinteger(L, 5);
-        UnloadTexture(texture);
+        GetTextureArgs(L, 1, texture);
+        if (AssetCache::Get().ReleaseTexture(texture.id)) return 0;
+        RunOnMainThread([=] { RunOnRenderThread([&] { UnloadTexture(texture); }); });
         return 0;
     }
 
+    // DrawTexture(texture, x, y, tint)
     inline int l_DrawTexture(lua_State* L) {
         Texture2D texture;
-        texture.id = (unsigned int)luaL_checkinteger(L, 1);
-        texture.width = (int)luaL_checkinteger(L, 2);
-        texture.height = (int)luaL_checkinteger(L, 3);
-        texture.mipmaps = (int)luaL_checkinteger(L, 4);
-        texture.format = (int)luaL_checkinteger(L, 5);
-        
-        int posX = (int)luaL_checkinteger(L, 6);
-        int posY = (int)luaL_checkinteger(L, 7);
-        Color tint = GetColorFromLua(L, 8);
-        
-        DrawTexture(texture, posX, posY, tint);
+        int arg = GetTextureArgs(L, 1, texture);
+        
+        int posX = (int)luaL_checkinteger(L, arg);
+        int posY = (int)luaL_checkinteger(L, arg + 1);
+        Color tint = GetColorFromLua(L, arg + 2);
+        
+        DrawPacket packet;
+        packet.command = DrawCommand::Texture;
+        packet.texture = texture;
+        packet.position = { (float)posX, (float)posY, 0.0f };
+        packet.color = tint;
+        SubmitDraw(packet);
         return 0;
     }
 
+    // DrawTexturePro(texture, source, dest, origin, rotation, tint)
     inline int l_DrawTexturePro(lua_State* L) {
         Texture2D texture;
-        texture.id = (unsigned int)luaL_checkinteger(L, 1);
-        texture.width = (int)luaL_checkinteger(L, 2);
-        texture.height = (int)luaL_checkinteger(L, 3);
-        texture.mipmaps = (int)luaL_checkinteger(L, 4);
-        texture.format = (int)luaL_checkinteger(L, 5);
-        
-        Rectangle source = GetRectangleFromLua(L, 6);
-        Rectangle dest = GetRectangleFromLua(L, 7);
-        Vector2 origin = GetVector2FromLua(L, 8);
-        float rotation = (float)luaL_checknumber(L, 9);
-        Color tint = GetColorFromLua(L, 10);
-        
-        DrawTexturePro(texture, source, dest, origin, rotation, tint);
+        int arg = GetTextureArgs(L, 1, texture);
+        
+        Rectangle source = GetRectangleFromLua(L, arg);
+        Rectangle dest = GetRectangleFromLua(L, arg + 1);
+        Vector2 origin = GetVector2FromLua(L, arg + 2);
+        float rotation = (float)luaL_checknumber(L, arg + 3);
+        Color tint = GetColorFromLua(L, arg + 4);
+        
+        DrawPacket packet;
+        packet.command = DrawCommand::TexturePro;
+        packet.texture = texture;
+        packet.source = source;
+        packet.dest = dest;
+        packet.origin = origin;
+        packet.rotation = rotation;
+        packet.color = tint;
+        SubmitDraw(packet);
         return 0;
     }
 
     
     inline int l_InitAudioDevice(lua_State* L) {
-        InitAudioDevice();
+        RunOnMainThread([] { InitAudioDevice(); });
         return 0;
     }
 
     inline int l_CloseAudioDevice(lua_State* L) {
-        CloseAudioDevice();
+        RunOnMainThread([] { CloseAudioDevice(); });
         return 0;
     }
 
@@ -621,7 +1762,7 @@ namespace MoonRay {
         Sound sound;
         sound.stream = *(AudioStream*)lua_touserdata(L, 1);
         sound.frameCount = (unsigned int)luaL_checkinteger(L, 2);
-        PlaySound(sound);
+        RunOnMainThread([=] { PlaySound(sound); });
         return 0;
     }
 
@@ -629,6 +1770,13 @@ namespace MoonRay {
     inline int l_GetRandomValue(lua_State* L) {
         int min = (int)luaL_checkinteger(L, 1);
         int max = (int)luaL_checkinteger(L, 2);
+        // raylib's generator isn't thread safe, parallel updates draw from their own
+        if (OnWorkerThread()) {
+            static thread_local std::minstd_rand generator{ std::random_device{}() };
+            if (min > max) std::swap(min, max);
+            lua_pushinteger(L, std::uniform_int_distribution<int>(min, max)(generator));
+            return 1;
+        }
         lua_pushinteger(L, GetRandomValue(min, max));
         return 1;
     }
@@ -641,395 +1789,335 @@ namespace MoonRay {
         return 1;
     }
 
-    
+
+    // --- API table ---
+    // The engine API is described once per process by ApiEntries(). A state only gets the
+    // MoonRay module table, which starts empty and creates an entry the first time a script
+    // reads it, and the globals table falls back to it. So DrawCircle, KEY_SPACE or RED work as
+    // globals, but a state pays only for the names its scripts use. MoonRay itself is an empty
+    // read-only proxy over the cache; assigning a global of the same name shadows the entry.
+
+    struct ApiEntry {
+        enum Kind { Function, Integer, ColorValue, Object };   // Object: function pushes the value
+        const char* name;
+        Kind kind;
+        lua_CFunction function;
+        lua_Integer integer;
+        Color color;
+    };
+
+    inline ApiEntry ApiFunction(const char* name, lua_CFunction function) { return { name, ApiEntry::Function, function, 0, {} }; }
+    inline ApiEntry ApiInteger(const char* name, lua_Integer value) { return { name, ApiEntry::Integer, nullptr, value, {} }; }
+    inline ApiEntry ApiColor(const char* name, Color color) { return { name, ApiEntry::ColorValue, nullptr, 0, color }; }
+    inline ApiEntry ApiObject(const char* name, lua_CFunction push) { return { name, ApiEntry::Object, push, 0, {} }; }
+
+    // Sorted by name for LookupApi
+    inline const std::vector<ApiEntry>& ApiEntries() {
+        static const std::vector<ApiEntry> entries = [] {
+            std::vector<ApiEntry> list = {
+                ApiFunction("Vector2", l_ValueNew<Vector2>),
+                ApiFunction("Vector3", l_ValueNew<Vector3>),
+                ApiFunction("Color", l_ValueNew<Color>),
+                ApiFunction("Rectangle", l_ValueNew<Rectangle>),
+                ApiFunction("FloatArray", l_FloatArrayNew),
+                ApiFunction("ColorArray", l_ColorArrayNew),
+
+                ApiFunction("InitWindow", l_InitWindow),
+                ApiFunction("CloseWindow", l_CloseWindow),
+                ApiFunction("WindowShouldClose", l_WindowShouldClose),
+                ApiFunction("SetTargetFPS", l_SetTargetFPS),
+
+                ApiFunction("BeginDrawing", l_BeginDrawing),
+                ApiFunction("EndDrawing", l_EndDrawing),
+                ApiFunction("ClearBackground", l_ClearBackground),
+
+                ApiFunction("DrawText", l_DrawText),
+                ApiFunction("DrawRectangle", l_DrawRectangle),
+                ApiFunction("DrawRectangleLines", l_DrawRectangleLines),
+                ApiFunction("DrawCircle", l_DrawCircle),
+                ApiFunction("DrawCircleLines", l_DrawCircleLines),
+                ApiFunction("DrawLine", l_DrawLine),
+                ApiFunction("DrawPixel", l_DrawPixel),
+                ApiFunction("DrawCirclesBatch", l_DrawCirclesBatch),
+                ApiFunction("DrawRectanglesBatch", l_DrawRectanglesBatch),
+
+                ApiFunction("DrawCube", l_DrawCube),
+                ApiFunction("DrawCubeWires", l_DrawCubeWires),
+                ApiFunction("DrawSphere", l_DrawSphere),
+                ApiFunction("DrawSphereWires", l_DrawSphereWires),
+                ApiFunction("DrawGrid", l_DrawGrid),
+
+                ApiFunction("BeginMode3D", l_BeginMode3D),
+                ApiFunction("EndMode3D", l_EndMode3D),
+                ApiFunction("BeginMode2D", l_BeginMode2D),
+                ApiFunction("EndMode2D", l_EndMode2D),
+                ApiFunction("UpdateCamera", l_UpdateCamera),
+
+                ApiFunction("IsKeyDown", l_IsKeyDown),
+                ApiFunction("IsKeyPressed", l_IsKeyPressed),
+                ApiFunction("IsKeyReleased", l_IsKeyReleased),
+                ApiFunction("IsKeyUp", l_IsKeyUp),
+                ApiFunction("GetKeyPressed", l_GetKeyPressed),
+                ApiFunction("GetCharPressed", l_GetCharPressed),
+
+                ApiFunction("GetMouseX", l_GetMouseX),
+                ApiFunction("GetMouseY", l_GetMouseY),
+                ApiFunction("GetMousePosition", l_GetMousePosition),
+                ApiFunction("GetMouseDelta", l_GetMouseDelta),
+                ApiFunction("GetMouseWheelMove", l_GetMouseWheelMove),
+                ApiFunction("IsMouseButtonDown", l_IsMouseButtonDown),
+                ApiFunction("IsMouseButtonPressed", l_IsMouseButtonPressed),
+                ApiFunction("IsMouseButtonReleased", l_IsMouseButtonReleased),
+                ApiFunction("IsMouseButtonUp", l_IsMouseButtonUp),
+                ApiObject("Input", l_PushInput),
+
+                ApiFunction("GetFrameTime", l_GetFrameTime),
+                ApiFunction("GetTime", l_GetTime),
+                ApiFunction("GetFPS", l_GetFPS),
+
+                ApiFunction("Vector2Add", l_Vector2Add),
+                ApiFunction("Vector2Subtract", l_Vector2Subtract),
+                ApiFunction("Vector2Scale", l_Vector2Scale),
+                ApiFunction("Vector2Length", l_Vector2Length),
+                ApiFunction("Vector2Distance", l_Vector2Distance),
+                ApiFunction("Vector2DotProduct", l_Vector2DotProduct),
+                ApiFunction("Vector2Angle", l_Vector2Angle),
+                ApiFunction("Vector2Normalize", l_Vector2Normalize),
+                ApiFunction("Vector2Rotate", l_Vector2Rotate),
+
+                ApiFunction("Vector3Add", l_Vector3Add),
+                ApiFunction("Vector3Subtract", l_Vector3Subtract),
+                ApiFunction("Vector3Scale", l_Vector3Scale),
+                ApiFunction("Vector3Length", l_Vector3Length),
+                ApiFunction("Vector3CrossProduct", l_Vector3CrossProduct),
+                ApiFunction("Vector3Normalize", l_Vector3Normalize),
+
+                ApiFunction("ColorFromHSV", l_ColorFromHSV),
+                ApiFunction("ColorAlpha", l_ColorAlpha),
+                ApiFunction("ColorToInt", l_ColorToInt),
+                ApiFunction("GetColor", l_GetColor),
+                ApiFunction("ColorAlphaBlend", l_ColorAlphaBlend),
+
+                ApiFunction("LoadTexture", l_LoadTexture),
+                ApiFunction("UnloadTexture", l_UnloadTexture),
+                ApiFunction("DrawTexture", l_DrawTexture),
+                ApiFunction("DrawTexturePro", l_DrawTexturePro),
+                ApiFunction("DrawSpritesBatch", l_DrawSpritesBatch),
+
+                ApiFunction("InitAudioDevice", l_InitAudioDevice),
+                ApiFunction("CloseAudioDevice", l_CloseAudioDevice),
+                ApiFunction("PlaySound", l_PlaySound),
+
+                ApiFunction("GetRandomValue", l_GetRandomValue),
+                ApiFunction("Clamp", l_Clamp),
+
+                ApiInteger("KEY_SPACE", KEY_SPACE),
+                ApiInteger("KEY_APOSTROPHE", KEY_APOSTROPHE),
+                ApiInteger("KEY_COMMA", KEY_COMMA),
+                ApiInteger("KEY_MINUS", KEY_MINUS),
+                ApiInteger("KEY_PERIOD", KEY_PERIOD),
+                ApiInteger("KEY_SLASH", KEY_SLASH),
+                ApiInteger("KEY_ZERO", KEY_ZERO),
+                ApiInteger("KEY_ONE", KEY_ONE),
+                ApiInteger("KEY_TWO", KEY_TWO),
+                ApiInteger("KEY_THREE", KEY_THREE),
+                ApiInteger("KEY_FOUR", KEY_FOUR),
+                ApiInteger("KEY_FIVE", KEY_FIVE),
+                ApiInteger("KEY_SIX", KEY_SIX),
+                ApiInteger("KEY_SEVEN", KEY_SEVEN),
+                ApiInteger("KEY_EIGHT", KEY_EIGHT),
+                ApiInteger("KEY_NINE", KEY_NINE),
+                ApiInteger("KEY_SEMICOLON", KEY_SEMICOLON),
+                ApiInteger("KEY_EQUAL", KEY_EQUAL),
+                ApiInteger("KEY_A", KEY_A),
+                ApiInteger("KEY_B", KEY_B),
+                ApiInteger("KEY_C", KEY_C),
+                ApiInteger("KEY_D", KEY_D),
+                ApiInteger("KEY_E", KEY_E),
+                ApiInteger("KEY_F", KEY_F),
+                ApiInteger("KEY_G", KEY_G),
+                ApiInteger("KEY_H", KEY_H),
+                ApiInteger("KEY_I", KEY_I),
+                ApiInteger("KEY_J", KEY_J),
+                ApiInteger("KEY_K", KEY_K),
+                ApiInteger("KEY_L", KEY_L),
+                ApiInteger("KEY_M", KEY_M),
+                ApiInteger("KEY_N", KEY_N),
+                ApiInteger("KEY_O", KEY_O),
+                ApiInteger("KEY_P", KEY_P),
+                ApiInteger("KEY_Q", KEY_Q),
+                ApiInteger("KEY_R", KEY_R),
+                ApiInteger("KEY_S", KEY_S),
+                ApiInteger("KEY_T", KEY_T),
+                ApiInteger("KEY_U", KEY_U),
+                ApiInteger("KEY_V", KEY_V),
+                ApiInteger("KEY_W", KEY_W),
+                ApiInteger("KEY_X", KEY_X),
+                ApiInteger("KEY_Y", KEY_Y),
+                ApiInteger("KEY_Z", KEY_Z),
+                ApiInteger("KEY_LEFT_BRACKET", KEY_LEFT_BRACKET),
+                ApiInteger("KEY_BACKSLASH", KEY_BACKSLASH),
+                ApiInteger("KEY_RIGHT_BRACKET", KEY_RIGHT_BRACKET),
+                ApiInteger("KEY_GRAVE", KEY_GRAVE),
+                ApiInteger("KEY_ESCAPE", KEY_ESCAPE),
+                ApiInteger("KEY_ENTER", KEY_ENTER),
+                ApiInteger("KEY_TAB", KEY_TAB),
+                ApiInteger("KEY_BACKSPACE", KEY_BACKSPACE),
+                ApiInteger("KEY_INSERT", KEY_INSERT),
+                ApiInteger("KEY_DELETE", KEY_DELETE),
+                ApiInteger("KEY_RIGHT", KEY_RIGHT),
+                ApiInteger("KEY_LEFT", KEY_LEFT),
+                ApiInteger("KEY_DOWN", KEY_DOWN),
+                ApiInteger("KEY_UP", KEY_UP),
+                ApiInteger("KEY_PAGE_UP", KEY_PAGE_UP),
+                ApiInteger("KEY_PAGE_DOWN", KEY_PAGE_DOWN),
+                ApiInteger("KEY_HOME", KEY_HOME),
+                ApiInteger("KEY_END", KEY_END),
+                ApiInteger("KEY_CAPS_LOCK", KEY_CAPS_LOCK),
+                ApiInteger("KEY_SCROLL_LOCK", KEY_SCROLL_LOCK),
+                ApiInteger("KEY_NUM_LOCK", KEY_NUM_LOCK),
+                ApiInteger("KEY_PRINT_SCREEN", KEY_PRINT_SCREEN),
+                ApiInteger("KEY_PAUSE", KEY_PAUSE),
+                ApiInteger("KEY_F1", KEY_F1),
+                ApiInteger("KEY_F2", KEY_F2),
+                ApiInteger("KEY_F3", KEY_F3),
+                ApiInteger("KEY_F4", KEY_F4),
+                ApiInteger("KEY_F5", KEY_F5),
+                ApiInteger("KEY_F6", KEY_F6),
+                ApiInteger("KEY_F7", KEY_F7),
+                ApiInteger("KEY_F8", KEY_F8),
+                ApiInteger("KEY_F9", KEY_F9),
+                ApiInteger("KEY_F10", KEY_F10),
+                ApiInteger("KEY_F11", KEY_F11),
+                ApiInteger("KEY_F12", KEY_F12),
+                ApiInteger("KEY_LEFT_SHIFT", KEY_LEFT_SHIFT),
+                ApiInteger("KEY_LEFT_CONTROL", KEY_LEFT_CONTROL),
+                ApiInteger("KEY_LEFT_ALT", KEY_LEFT_ALT),
+                ApiInteger("KEY_LEFT_SUPER", KEY_LEFT_SUPER),
+                ApiInteger("KEY_RIGHT_SHIFT", KEY_RIGHT_SHIFT),
+                ApiInteger("KEY_RIGHT_CONTROL", KEY_RIGHT_CONTROL),
+                ApiInteger("KEY_RIGHT_ALT", KEY_RIGHT_ALT),
+                ApiInteger("KEY_RIGHT_SUPER", KEY_RIGHT_SUPER),
+                ApiInteger("KEY_KB_MENU", KEY_KB_MENU),
+
+                ApiInteger("MOUSE_BUTTON_LEFT", MOUSE_BUTTON_LEFT),
+                ApiInteger("MOUSE_BUTTON_RIGHT", MOUSE_BUTTON_RIGHT),
+                ApiInteger("MOUSE_BUTTON_MIDDLE", MOUSE_BUTTON_MIDDLE),
+                ApiInteger("MOUSE_BUTTON_SIDE", MOUSE_BUTTON_SIDE),
+                ApiInteger("MOUSE_BUTTON_EXTRA", MOUSE_BUTTON_EXTRA),
+                ApiInteger("MOUSE_BUTTON_FORWARD", MOUSE_BUTTON_FORWARD),
+                ApiInteger("MOUSE_BUTTON_BACK", MOUSE_BUTTON_BACK),
+
+                ApiInteger("CAMERA_CUSTOM", CAMERA_CUSTOM),
+                ApiInteger("CAMERA_FREE", CAMERA_FREE),
+                ApiInteger("CAMERA_ORBITAL", CAMERA_ORBITAL),
+                ApiInteger("CAMERA_FIRST_PERSON", CAMERA_FIRST_PERSON),
+                ApiInteger("CAMERA_THIRD_PERSON", CAMERA_THIRD_PERSON),
+                ApiInteger("CAMERA_PERSPECTIVE", CAMERA_PERSPECTIVE),
+                ApiInteger("CAMERA_ORTHOGRAPHIC", CAMERA_ORTHOGRAPHIC),
+
+                ApiColor("LIGHTGRAY", LIGHTGRAY),
+                ApiColor("GRAY", GRAY),
+                ApiColor("DARKGRAY", DARKGRAY),
+                ApiColor("YELLOW", YELLOW),
+                ApiColor("GOLD", GOLD),
+                ApiColor("ORANGE", ORANGE),
+                ApiColor("PINK", PINK),
+                ApiColor("RED", RED),
+                ApiColor("MAROON", MAROON),
+                ApiColor("GREEN", GREEN),
+                ApiColor("LIME", LIME),
+                ApiColor("DARKGREEN", DARKGREEN),
+                ApiColor("SKYBLUE", SKYBLUE),
+                ApiColor("BLUE", BLUE),
+                ApiColor("DARKBLUE", DARKBLUE),
+                ApiColor("PURPLE", PURPLE),
+                ApiColor("VIOLET", VIOLET),
+                ApiColor("DARKPURPLE", DARKPURPLE),
+                ApiColor("BEIGE", BEIGE),
+                ApiColor("BROWN", BROWN),
+                ApiColor("DARKBROWN", DARKBROWN),
+                ApiColor("WHITE", WHITE),
+                ApiColor("BLACK", BLACK),
+                ApiColor("BLANK", BLANK),
+                ApiColor("MAGENTA", MAGENTA),
+                ApiColor("RAYWHITE", RAYWHITE),
+            };
+            std::sort(list.begin(), list.end(), [](const ApiEntry& a, const ApiEntry& b) { return std::strcmp(a.name, b.name) < 0; });
+            return list;
+        }();
+        return entries;
+    }
+
+    inline const ApiEntry* LookupApi(const char* name) {
+        const std::vector<ApiEntry>& entries = ApiEntries();
+        auto it = std::lower_bound(entries.begin(), entries.end(), name,
+            [](const ApiEntry& entry, const char* key) { return std::strcmp(entry.name, key) < 0; });
+        return it != entries.end() && std::strcmp(it->name, name) == 0 ? &*it : nullptr;
+    }
+
+    // __index of the cache: creates the entry, keeps it in the cache and returns it. The entry is
+    // also stored in _G (unless a script set that global itself), so later reads are plain global
+    // lookups that no longer go through _G's metatable, which a script may replace (strict mode).
+    inline int l_ApiIndex(lua_State* L) {
+        const ApiEntry* entry = lua_type(L, 2) == LUA_TSTRING ? LookupApi(lua_tostring(L, 2)) : nullptr;
+        if (!entry) return 0;
+
+        switch (entry->kind) {
+            case ApiEntry::Function: lua_pushcfunction(L, entry->function); break;
+            case ApiEntry::Integer: lua_pushinteger(L, entry->integer); break;
+            case ApiEntry::ColorValue: PushReadOnlyValue(L, entry->color); break;
+            case ApiEntry::Object: entry->function(L); break;
+        }
+        lua_pushvalue(L, 2);
+        lua_pushvalue(L, -2);
+        lua_rawset(L, 1);
+
+        lua_pushglobaltable(L);
+        lua_pushvalue(L, 2);
+        if (lua_rawget(L, -2) == LUA_TNIL) {
+            lua_pushvalue(L, 2);
+            lua_pushvalue(L, -4);
+            lua_rawset(L, -4);
+        }
+        lua_pop(L, 2);
+        return 1;
+    }
+
+    inline int l_ApiNewIndex(lua_State* L) {
+        return luaL_error(L, "MoonRay.%s is read-only", luaL_tolstring(L, 2, nullptr));
+    }
+
     inline void RegisterAPI(lua_State* L) {
-        
-        lua_register(L, "InitWindow", l_InitWindow);
-        lua_register(L, "CloseWindow", l_CloseWindow);
-        lua_register(L, "WindowShouldClose", l_WindowShouldClose);
-        lua_register(L, "SetTargetFPS", l_SetTargetFPS);
-        
-        
-        lua_register(L, "BeginDrawing", l_BeginDrawing);
-        lua_register(L, "EndDrawing", l_EndDrawing);
-        lua_register(L, "ClearBackground", l_ClearBackground);
-        
-        
-        lua_register(L, "DrawText", l_DrawText);
-        lua_register(L, "DrawRectangle", l_DrawRectangle);
-        lua_register(L, "DrawRectangleLines", l_DrawRectangleLines);
-        lua_register(L, "DrawCircle", l_DrawCircle);
-        lua_register(L, "DrawCircleLines", l_DrawCircleLines);
-        lua_register(L, "DrawLine", l_DrawLine);
-        lua_register(L, "DrawPixel", l_DrawPixel);
-        
-        
-        lua_register(L, "DrawCube", l_DrawCube);
-        lua_register(L, "DrawCubeWires", l_DrawCubeWires);
-        lua_register(L, "DrawSphere", l_DrawSphere);
-        lua_register(L, "DrawSphereWires", l_DrawSphereWires);
-        lua_register(L, "DrawGrid", l_DrawGrid);
-        
-        
-        lua_register(L, "BeginMode3D", l_BeginMode3D);
-        lua_register(L, "EndMode3D", l_EndMode3D);
-        lua_register(L, "BeginMode2D", l_BeginMode2D);
-        lua_register(L, "EndMode2D", l_EndMode2D);
-        lua_register(L, "UpdateCamera", l_UpdateCamera);
-        
-        
-        lua_register(L, "IsKeyDown", l_IsKeyDown);
-        lua_register(L, "IsKeyPressed", l_IsKeyPressed);
-        lua_register(L, "IsKeyReleased", l_IsKeyReleased);
-        lua_register(L, "IsKeyUp", l_IsKeyUp);
-        lua_register(L, "GetKeyPressed", l_GetKeyPressed);
-        lua_register(L, "GetCharPressed", l_GetCharPressed);
-        
-        
-        lua_register(L, "GetMouseX", l_GetMouseX);
-        lua_register(L, "GetMouseY", l_GetMouseY);
-        lua_register(L, "GetMousePosition", l_GetMousePosition);
-        lua_register(L, "GetMouseDelta", l_GetMouseDelta);
-        lua_register(L, "GetMouseWheelMove", l_GetMouseWheelMove);
-        lua_register(L, "IsMouseButtonDown", l_IsMouseButtonDown);
-        lua_register(L, "IsMouseButtonPressed", l_IsMouseButtonPressed);
-        lua_register(L, "IsMouseButtonReleased", l_IsMouseButtonReleased);
-        lua_register(L, "IsMouseButtonUp", l_IsMouseButtonUp);
-        
-        
-        lua_register(L, "GetFrameTime", l_GetFrameTime);
-        lua_register(L, "GetTime", l_GetTime);
-        lua_register(L, "GetFPS", l_GetFPS);
-        
-        
-        lua_register(L, "Vector2Add", l_Vector2Add);
-        lua_register(L, "Vector2Subtract", l_Vector2Subtract);
-        lua_register(L, "Vector2Scale", l_Vector2Scale);
-        lua_register(L, "Vector2Length", l_Vector2Length);
-        lua_register(L, "Vector2Distance", l_Vector2Distance);
-        lua_register(L, "Vector2DotProduct", l_Vector2DotProduct);
-        lua_register(L, "Vector2Angle", l_Vector2Angle);
-        lua_register(L, "Vector2Normalize", l_Vector2Normalize);
-        lua_register(L, "Vector2Rotate", l_Vector2Rotate);
-        
-        
-        lua_register(L, "Vector3Add", l_Vector3Add);
-        lua_register(L, "Vector3Subtract", l_Vector3Subtract);
-        lua_register(L, "Vector3Scale", l_Vector3Scale);
-        lua_register(L, "Vector3Length", l_Vector3Length);
-        lua_register(L, "Vector3CrossProduct", l_Vector3CrossProduct);
-        lua_register(L, "Vector3Normalize", l_Vector3Normalize);
-        
-        
-        lua_register(L, "ColorFromHSV", l_ColorFromHSV);
-        lua_register(L, "ColorAlpha", l_ColorAlpha);
-        lua_register(L, "ColorAlphaBlend", l_ColorAlphaBlend);
-        
-        
-        lua_register(L, "LoadTexture", l_LoadTexture);
-        lua_register(L, "UnloadTexture", l_UnloadTexture);
-        lua_register(L, "DrawTexture", l_DrawTexture);
-        lua_register(L, "DrawTexturePro", l_DrawTexturePro);
-        
-        
-        lua_register(L, "InitAudioDevice", l_InitAudioDevice);
-        lua_register(L, "CloseAudioDevice", l_CloseAudioDevice);
-        lua_register(L, "PlaySound", l_PlaySound);
-        
-        
-        lua_register(L, "GetRandomValue", l_GetRandomValue);
-        lua_register(L, "Clamp", l_Clamp);
-        
-        
-        lua_pushinteger(L, KEY_SPACE); lua_setglobal(L, "KEY_SPACE");
-        lua_pushinteger(L, KEY_APOSTROPHE); lua_setglobal(L, "KEY_APOSTROPHE");
-        lua_pushinteger(L, KEY_COMMA); lua_setglobal(L, "KEY_COMMA");
-        lua_pushinteger(L, KEY_MINUS); lua_setglobal(L, "KEY_MINUS");
-        lua_pushinteger(L, KEY_PERIOD); lua_setglobal(L, "KEY_PERIOD");
-        lua_pushinteger(L, KEY_SLASH); lua_setglobal(L, "KEY_SLASH");
-        lua_pushinteger(L, KEY_ZERO); lua_setglobal(L, "KEY_ZERO");
-        lua_pushinteger(L, KEY_ONE); lua_setglobal(L, "KEY_ONE");
-        lua_pushinteger(L, KEY_TWO); lua_setglobal(L, "KEY_TWO");
-        lua_pushinteger(L, KEY_THREE); lua_setglobal(L, "KEY_THREE");
-        lua_pushinteger(L, KEY_FOUR); lua_setglobal(L, "KEY_FOUR");
-        lua_pushinteger(L, KEY_FIVE); lua_setglobal(L, "KEY_FIVE");
-        lua_pushinteger(L, KEY_SIX); lua_setglobal(L, "KEY_SIX");
-        lua_pushinteger(L, KEY_SEVEN); lua_setglobal(L, "KEY_SEVEN");
-        lua_pushinteger(L, KEY_EIGHT); lua_setglobal(L, "KEY_EIGHT");
-        lua_pushinteger(L, KEY_NINE); lua_setglobal(L, "KEY_NINE");
-        lua_pushinteger(L, KEY_SEMICOLON); lua_setglobal(L, "KEY_SEMICOLON");
-        lua_pushinteger(L, KEY_EQUAL); lua_setglobal(L, "KEY_EQUAL");
-        lua_pushinteger(L, KEY_A); lua_setglobal(L, "KEY_A");
-        lua_pushinteger(L, KEY_B); lua_setglobal(L, "KEY_B");
-        lua_pushinteger(L, KEY_C); lua_setglobal(L, "KEY_C");
-        lua_pushinteger(L, KEY_D); lua_setglobal(L, "KEY_D");
-        lua_pushinteger(L, KEY_E); lua_setglobal(L, "KEY_E");
-        lua_pushinteger(L, KEY_F); lua_setglobal(L, "KEY_F");
-        lua_pushinteger(L, KEY_G); lua_setglobal(L, "KEY_G");
-        lua_pushinteger(L, KEY_H); lua_setglobal(L, "KEY_H");
-        lua_pushinteger(L, KEY_I); lua_setglobal(L, "KEY_I");
-        lua_pushinteger(L, KEY_J); lua_setglobal(L, "KEY_J");
-        lua_pushinteger(L, KEY_K); lua_setglobal(L, "KEY_K");
-        lua_pushinteger(L, KEY_L); lua_setglobal(L, "KEY_L");
-        lua_pushinteger(L, KEY_M); lua_setglobal(L, "KEY_M");
-        lua_pushinteger(L, KEY_N); lua_setglobal(L, "KEY_N");
-        lua_pushinteger(L, KEY_O); lua_setglobal(L, "KEY_O");
-        lua_pushinteger(L, KEY_P); lua_setglobal(L, "KEY_P");
-        lua_pushinteger(L, KEY_Q); lua_setglobal(L, "KEY_Q");
-        lua_pushinteger(L, KEY_R); lua_setglobal(L, "KEY_R");
-        lua_pushinteger(L, KEY_S); lua_setglobal(L, "KEY_S");
-        lua_pushinteger(L, KEY_T); lua_setglobal(L, "KEY_T");
-        lua_pushinteger(L, KEY_U); lua_setglobal(L, "KEY_U");
-        lua_pushinteger(L, KEY_V); lua_setglobal(L, "KEY_V");
-        lua_pushinteger(L, KEY_W); lua_setglobal(L, "KEY_W");
-        lua_pushinteger(L, KEY_X); lua_setglobal(L, "KEY_X");
-        lua_pushinteger(L, KEY_Y); lua_setglobal(L, "KEY_Y");
-        lua_pushinteger(L, KEY_Z); lua_setglobal(L, "KEY_Z");
-        lua_pushinteger(L, KEY_LEFT_BRACKET); lua_setglobal(L, "KEY_LEFT_BRACKET");
-        lua_pushinteger(L, KEY_BACKSLASH); lua_setglobal(L, "KEY_BACKSLASH");
-        lua_pushinteger(L, KEY_RIGHT_BRACKET); lua_setglobal(L, "KEY_RIGHT_BRACKET");
-        lua_pushinteger(L, KEY_GRAVE); lua_setglobal(L, "KEY_GRAVE");
-        lua_pushinteger(L, KEY_ESCAPE); lua_setglobal(L, "KEY_ESCAPE");
-        lua_pushinteger(L, KEY_ENTER); lua_setglobal(L, "KEY_ENTER");
-        lua_pushinteger(L, KEY_TAB); lua_setglobal(L, "KEY_TAB");
-        lua_pushinteger(L, KEY_BACKSPACE); lua_setglobal(L, "KEY_BACKSPACE");
-        lua_pushinteger(L, KEY_INSERT); lua_setglobal(L, "KEY_INSERT");
-        lua_pushinteger(L, KEY_DELETE); lua_setglobal(L, "KEY_DELETE");
-        lua_pushinteger(L, KEY_RIGHT); lua_setglobal(L, "KEY_RIGHT");
-        lua_pushinteger(L, KEY_LEFT); lua_setglobal(L, "KEY_LEFT");
-        lua_pushinteger(L, KEY_DOWN); lua_setglobal(L, "KEY_DOWN");
-        lua_pushinteger(L, KEY_UP); lua_setglobal(L, "KEY_UP");
-        lua_pushinteger(L, KEY_PAGE_UP); lua_setglobal(L, "KEY_PAGE_UP");
-        lua_pushinteger(L, KEY_PAGE_DOWN); lua_setglobal(L, "KEY_PAGE_DOWN");
-        lua_pushinteger(L, KEY_HOME); lua_setglobal(L, "KEY_HOME");
-        lua_pushinteger(L, KEY_END); lua_setglobal(L, "KEY_END");
-        lua_pushinteger(L, KEY_CAPS_LOCK); lua_setglobal(L, "KEY_CAPS_LOCK");
-        lua_pushinteger(L, KEY_SCROLL_LOCK); lua_setglobal(L, "KEY_SCROLL_LOCK");
-        lua_pushinteger(L, KEY_NUM_LOCK); lua_setglobal(L, "KEY_NUM_LOCK");
-        lua_pushinteger(L, KEY_PRINT_SCREEN); lua_setglobal(L, "KEY_PRINT_SCREEN");
-        lua_pushinteger(L, KEY_PAUSE); lua_setglobal(L, "KEY_PAUSE");
-        lua_pushinteger(L, KEY_F1); lua_setglobal(L, "KEY_F1");
-        lua_pushinteger(L, KEY_F2); lua_setglobal(L, "KEY_F2");
-        lua_pushinteger(L, KEY_F3); lua_setglobal(L, "KEY_F3");
-        lua_pushinteger(L, KEY_F4); lua_setglobal(L, "KEY_F4");
-        lua_pushinteger(L, KEY_F5); lua_setglobal(L, "KEY_F5");
-        lua_pushinteger(L, KEY_F6); lua_setglobal(L, "KEY_F6");
-        lua_pushinteger(L, KEY_F7); lua_setglobal(L, "KEY_F7");
-        lua_pushinteger(L, KEY_F8); lua_setglobal(L, "KEY_F8");
-        lua_pushinteger(L, KEY_F9); lua_setglobal(L, "KEY_F9");
-        lua_pushinteger(L, KEY_F10); lua_setglobal(L, "KEY_F10");
-        lua_pushinteger(L, KEY_F11); lua_setglobal(L, "KEY_F11");
-        lua_pushinteger(L, KEY_F12); lua_setglobal(L, "KEY_F12");
-        lua_pushinteger(L, KEY_LEFT_SHIFT); lua_setglobal(L, "KEY_LEFT_SHIFT");
-        lua_pushinteger(L, KEY_LEFT_CONTROL); lua_setglobal(L, "KEY_LEFT_CONTROL");
-        lua_pushinteger(L, KEY_LEFT_ALT); lua_setglobal(L, "KEY_LEFT_ALT");
-        lua_pushinteger(L, KEY_LEFT_SUPER); lua_setglobal(L, "KEY_LEFT_SUPER");
-        lua_pushinteger(L, KEY_RIGHT_SHIFT); lua_setglobal(L, "KEY_RIGHT_SHIFT");
-        lua_pushinteger(L, KEY_RIGHT_CONTROL); lua_setglobal(L, "KEY_RIGHT_CONTROL");
-        lua_pushinteger(L, KEY_RIGHT_ALT); lua_setglobal(L, "KEY_RIGHT_ALT");
-        lua_pushinteger(L, KEY_RIGHT_SUPER); lua_setglobal(L, "KEY_RIGHT_SUPER");
-        lua_pushinteger(L, KEY_KB_MENU); lua_setglobal(L, "KEY_KB_MENU");
-        
-        
-        lua_pushinteger(L, MOUSE_BUTTON_LEFT); lua_setglobal(L, "MOUSE_BUTTON_LEFT");
-        lua_pushinteger(L, MOUSE_BUTTON_RIGHT); lua_setglobal(L, "MOUSE_BUTTON_RIGHT");
-        lua_pushinteger(L, MOUSE_BUTTON_MIDDLE); lua_setglobal(L, "MOUSE_BUTTON_MIDDLE");
-        lua_pushinteger(L, MOUSE_BUTTON_SIDE); lua_setglobal(L, "MOUSE_BUTTON_SIDE");
-        lua_pushinteger(L, MOUSE_BUTTON_EXTRA); lua_setglobal(L, "MOUSE_BUTTON_EXTRA");
-        lua_pushinteger(L, MOUSE_BUTTON_FORWARD); lua_setglobal(L, "MOUSE_BUTTON_FORWARD");
-        lua_pushinteger(L, MOUSE_BUTTON_BACK); lua_setglobal(L, "MOUSE_BUTTON_BACK");
-        
-        
-        lua_pushinteger(L, CAMERA_CUSTOM); lua_setglobal(L, "CAMERA_CUSTOM");
-        lua_pushinteger(L, CAMERA_FREE); lua_setglobal(L, "CAMERA_FREE");
-        lua_pushinteger(L, CAMERA_ORBITAL); lua_setglobal(L, "CAMERA_ORBITAL");
-        lua_pushinteger(L, CAMERA_FIRST_PERSON); lua_setglobal(L, "CAMERA_FIRST_PERSON");
-        lua_pushinteger(L, CAMERA_THIRD_PERSON); lua_setglobal(L, "CAMERA_THIRD_PERSON");
-        lua_pushinteger(L, CAMERA_PERSPECTIVE); lua_setglobal(L, "CAMERA_PERSPECTIVE");
-        lua_pushinteger(L, CAMERA_ORTHOGRAPHIC); lua_setglobal(L, "CAMERA_ORTHOGRAPHIC");
-        
-        
-        lua_createtable(L, 4, 0);
-        lua_pushinteger(L, LIGHTGRAY.r); lua_rawseti(L, -2, 1);
-        lua_pushinteger(L, LIGHTGRAY.g); lua_rawseti(L, -2, 2);
-        lua_pushinteger(L, LIGHTGRAY.b); lua_rawseti(L, -2, 3);
-        lua_pushinteger(L, LIGHTGRAY.a); lua_rawseti(L, -2, 4);
-        lua_setglobal(L, "LIGHTGRAY");
-        
-        lua_createtable(L, 4, 0);
-        lua_pushinteger(L, GRAY.r); lua_rawseti(L, -2, 1);
-        lua_pushinteger(L, GRAY.g); lua_rawseti(L, -2, 2);
-        lua_pushinteger(L, GRAY.b); lua_rawseti(L, -2, 3);
-        lua_pushinteger(L, GRAY.a); lua_rawseti(L, -2, 4);
-        lua_setglobal(L, "GRAY");
-        
-        lua_createtable(L, 4, 0);
-        lua_pushinteger(L, DARKGRAY.r); lua_rawseti(L, -2, 1);
-        lua_pushinteger(L, DARKGRAY.g); lua_rawseti(L, -2, 2);
-        lua_pushinteger(L, DARKGRAY.b); lua_rawseti(L, -2, 3);
-        lua_pushinteger(L, DARKGRAY.a); lua_rawseti(L, -2, 4);
-        lua_setglobal(L, "DARKGRAY");
-        
-        lua_createtable(L, 4, 0);
-        lua_pushinteger(L, YELLOW.r); lua_rawseti(L, -2, 1);
-        lua_pushinteger(L, YELLOW.g); lua_rawseti(L, -2, 2);
-        lua_pushinteger(L, YELLOW.b); lua_rawseti(L, -2, 3);
-        lua_pushinteger(L, YELLOW.a); lua_rawseti(L, -2, 4);
-        lua_setglobal(L, "YELLOW");
-        
-        lua_createtable(L, 4, 0);
-        lua_pushinteger(L, GOLD.r); lua_rawseti(L, -2, 1);
-        lua_pushinteger(L, GOLD.g); lua_rawseti(L, -2, 2);
-        lua_pushinteger(L, GOLD.b); lua_rawseti(L, -2, 3);
-        lua_pushinteger(L, GOLD.a); lua_rawseti(L, -2, 4);
-        lua_setglobal(L, "GOLD");
-        
-        lua_createtable(L, 4, 0);
-        lua_pushinteger(L, ORANGE.r); lua_rawseti(L, -2, 1);
-        lua_pushinteger(L, ORANGE.g); lua_rawseti(L, -2, 2);
-        lua_pushinteger(L, ORANGE.b); lua_rawseti(L, -2, 3);
-        lua_pushinteger(L, ORANGE.a); lua_rawseti(L, -2, 4);
-        lua_setglobal(L, "ORANGE");
-        
-        lua_createtable(L, 4, 0);
-        lua_pushinteger(L, PINK.r); lua_rawseti(L, -2, 1);
-        lua_pushinteger(L, PINK.g); lua_rawseti(L, -2, 2);
-        lua_pushinteger(L, PINK.b); lua_rawseti(L, -2, 3);
-        lua_pushinteger(L, PINK.a); lua_rawseti(L, -2, 4);
-        lua_setglobal(L, "PINK");
-        
-        lua_createtable(L, 4, 0);
-        lua_pushinteger(L, RED.r); lua_rawseti(L, -2, 1);
-        lua_pushinteger(L, RED.g); lua_rawseti(L, -2, 2);
-        lua_pushinteger(L, RED.b); lua_rawseti(L, -2, 3);
-        lua_pushinteger(L, RED.a); lua_rawseti(L, -2, 4);
-        lua_setglobal(L, "RED");
-        
-        lua_createtable(L, 4, 0);
-        lua_pushinteger(L, MAROON.r); lua_rawseti(L, -2, 1);
-        lua_pushinteger(L, MAROON.g); lua_rawseti(L, -2, 2);
-        lua_pushinteger(L, MAROON.b); lua_rawseti(L, -2, 3);
-        lua_pushinteger(L, MAROON.a); lua_rawseti(L, -2, 4);
-        lua_setglobal(L, "MAROON");
-        
-        lua_createtable(L, 4, 0);
-        lua_pushinteger(L, GREEN.r); lua_rawseti(L, -2, 1);
-        lua_pushinteger(L, GREEN.g); lua_rawseti(L, -2, 2);
-        lua_pushinteger(L, GREEN.b); lua_rawseti(L, -2, 3);
-        lua_pushinteger(L, GREEN.a); lua_rawseti(L, -2, 4);
-        lua_setglobal(L, "GREEN");
-        
-        lua_createtable(L, 4, 0);
-        lua_pushinteger(L, LIME.r); lua_rawseti(L, -2, 1);
-        lua_pushinteger(L, LIME.g); lua_rawseti(L, -2, 2);
-        lua_pushinteger(L, LIME.b); lua_rawseti(L, -2, 3);
-        lua_pushinteger(L, LIME.a); lua_rawseti(L, -2, 4);
-        lua_setglobal(L, "LIME");
-        
-        lua_createtable(L, 4, 0);
-        lua_pushinteger(L, DARKGREEN.r); lua_rawseti(L, -2, 1);
-        lua_pushinteger(L, DARKGREEN.g); lua_rawseti(L, -2, 2);
-        lua_pushinteger(L, DARKGREEN.b); lua_rawseti(L, -2, 3);
-        lua_pushinteger(L, DARKGREEN.a); lua_rawseti(L, -2, 4);
-        lua_setglobal(L, "DARKGREEN");
-        
-        lua_createtable(L, 4, 0);
-        lua_pushinteger(L, SKYBLUE.r); lua_rawseti(L, -2, 1);
-        lua_pushinteger(L, SKYBLUE.g); lua_rawseti(L, -2, 2);
-        lua_pushinteger(L, SKYBLUE.b); lua_rawseti(L, -2, 3);
-        lua_pushinteger(L, SKYBLUE.a); lua_rawseti(L, -2, 4);
-        lua_setglobal(L, "SKYBLUE");
-        
-        lua_createtable(L, 4, 0);
-        lua_pushinteger(L, BLUE.r); lua_rawseti(L, -2, 1);
-        lua_pushinteger(L, BLUE.g); lua_rawseti(L, -2, 2);
-        lua_pushinteger(L, BLUE.b); lua_rawseti(L, -2, 3);
-        lua_pushinteger(L, BLUE.a); lua_rawseti(L, -2, 4);
-        lua_setglobal(L, "BLUE");
-        
-        lua_createtable(L, 4, 0);
-        lua_pushinteger(L, DARKBLUE.r); lua_rawseti(L, -2, 1);
-        lua_pushinteger(L, DARKBLUE.g); lua_rawseti(L, -2, 2);
-        lua_pushinteger(L, DARKBLUE.b); lua_rawseti(L, -2, 3);
-        lua_pushinteger(L, DARKBLUE.a); lua_rawseti(L, -2, 4);
-        lua_setglobal(L, "DARKBLUE");
-        
-        lua_createtable(L, 4, 0);
-        lua_pushinteger(L, PURPLE.r); lua_rawseti(L, -2, 1);
-        lua_pushinteger(L, PURPLE.g); lua_rawseti(L, -2, 2);
-        lua_pushinteger(L, PURPLE.b); lua_rawseti(L, -2, 3);
-        lua_pushinteger(L, PURPLE.a); lua_rawseti(L, -2, 4);
-        lua_setglobal(L, "PURPLE");
-        
-        lua_createtable(L, 4, 0);
-        lua_pushinteger(L, VIOLET.r); lua_rawseti(L, -2, 1);
-        lua_pushinteger(L, VIOLET.g); lua_rawseti(L, -2, 2);
-        lua_pushinteger(L, VIOLET.b); lua_rawseti(L, -2, 3);
-        lua_pushinteger(L, VIOLET.a); lua_rawseti(L, -2, 4);
-        lua_setglobal(L, "VIOLET");
-        
-        lua_createtable(L, 4, 0);
-        lua_pushinteger(L, DARKPURPLE.r); lua_rawseti(L, -2, 1);
-        lua_pushinteger(L, DARKPURPLE.g); lua_rawseti(L, -2, 2);
-        lua_pushinteger(L, DARKPURPLE.b); lua_rawseti(L, -2, 3);
-        lua_pushinteger(L, DARKPURPLE.a); lua_rawseti(L, -2, 4);
-        lua_setglobal(L, "DARKPURPLE");
-        
-        lua_createtable(L, 4, 0);
-        lua_pushinteger(L, BEIGE.r); lua_rawseti(L, -2, 1);
-        lua_pushinteger(L, BEIGE.g); lua_rawseti(L, -2, 2);
-        lua_pushinteger(L, BEIGE.b); lua_rawseti(L, -2, 3);
-        lua_pushinteger(L, BEIGE.a); lua_rawseti(L, -2, 4);
-        lua_setglobal(L, "BEIGE");
-        
-        lua_createtable(L, 4, 0);
-        lua_pushinteger(L, BROWN.r); lua_rawseti(L, -2, 1);
-        lua_pushinteger(L, BROWN.g); lua_rawseti(L, -2, 2);
-        lua_pushinteger(L, BROWN.b); lua_rawseti(L, -2, 3);
-        lua_pushinteger(L, BROWN.a); lua_rawseti(L, -2, 4);
-        lua_setglobal(L, "BROWN");
-        
-        lua_createtable(L, 4, 0);
-        lua_pushinteger(L, DARKBROWN.r); lua_rawseti(L, -2, 1);
-        lua_pushinteger(L, DARKBROWN.g); lua_rawseti(L, -2, 2);
-        lua_pushinteger(L, DARKBROWN.b); lua_rawseti(L, -2, 3);
-        lua_pushinteger(L, DARKBROWN.a); lua_rawseti(L, -2, 4);
-        lua_setglobal(L, "DARKBROWN");
-        
-        lua_createtable(L, 4, 0);
-        lua_pushinteger(L, WHITE.r); lua_rawseti(L, -2, 1);
-        lua_pushinteger(L, WHITE.g); lua_rawseti(L, -2, 2);
-        lua_pushinteger(L, WHITE.b); lua_rawseti(L, -2, 3);
-        lua_pushinteger(L, WHITE.a); lua_rawseti(L, -2, 4);
-        lua_setglobal(L, "WHITE");
-        
-        lua_createtable(L, 4, 0);
-        lua_pushinteger(L, BLACK.r); lua_rawseti(L, -2, 1);
-        lua_pushinteger(L, BLACK.g); lua_rawseti(L, -2, 2);
-        lua_pushinteger(L, BLACK.b); lua_rawseti(L, -2, 3);
-        lua_pushinteger(L, BLACK.a); lua_rawseti(L, -2, 4);
-        lua_setglobal(L, "BLACK");
-        
-        lua_createtable(L, 4, 0);
-        lua_pushinteger(L, BLANK.r); lua_rawseti(L, -2, 1);
-        lua_pushinteger(L, BLANK.g); lua_rawseti(L, -2, 2);
-        lua_pushinteger(L, BLANK.b); lua_rawseti(L, -2, 3);
-        lua_pushinteger(L, BLANK.a); lua_rawseti(L, -2, 4);
-        lua_setglobal(L, "BLANK");
-        
-        lua_createtable(L, 4, 0);
-        lua_pushinteger(L, MAGENTA.r); lua_rawseti(L, -2, 1);
-        lua_pushinteger(L, MAGENTA.g); lua_rawseti(L, -2, 2);
-        lua_pushinteger(L, MAGENTA.b); lua_rawseti(L, -2, 3);
-        lua_pushinteger(L, MAGENTA.a); lua_rawseti(L, -2, 4);
-        lua_setglobal(L, "MAGENTA");
-        
-        lua_createtable(L, 4, 0);
-        lua_pushinteger(L, RAYWHITE.r); lua_rawseti(L, -2, 1);
-        lua_pushinteger(L, RAYWHITE.g); lua_rawseti(L, -2, 2);
-        lua_pushinteger(L, RAYWHITE.b); lua_rawseti(L, -2, 3);
-        lua_pushinteger(L, RAYWHITE.a); lua_rawseti(L, -2, 4);
-        lua_setglobal(L, "RAYWHITE");
+        RegisterValueTypes(L);
+        RegisterFloatArray(L);
+        RegisterColorArray(L);
+        RegisterTexture(L);
+
+        // Cache, filled by l_ApiIndex
+        lua_newtable(L);
+        lua_createtable(L, 0, 1);
+        lua_pushcfunction(L, l_ApiIndex);
+        lua_setfield(L, -2, "__index");
+        lua_setmetatable(L, -2);
+
+        // Globals fall back to the cache
+        lua_pushglobaltable(L);
+        lua_createtable(L, 0, 1);
+        lua_pushvalue(L, -3);
+        lua_setfield(L, -2, "__index");
+        lua_setmetatable(L, -2);
+        lua_pop(L, 1);
+
+        lua_newtable(L);
+        lua_createtable(L, 0, 2);
+        lua_pushvalue(L, -3);
+        lua_setfield(L, -2, "__index");
+        lua_pushcfunction(L, l_ApiNewIndex);
+        lua_setfield(L, -2, "__newindex");
+        lua_setmetatable(L, -2);
+        lua_setglobal(L, "MoonRay");
+        lua_pop(L, 1);
     }
 }
 
@@ -0,0 +1,191 @@
+/*
+ * Copyright (C) 2026 Artem Svitlov (Moscow, Russia)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// Debug windows for Lua scripts: heap and GC cost of every ScriptVM (F3) and the sampling
+// profiler's flame view (F4). Call them inside the ImGui frame on the render thread.
+
+#ifndef MOONRAY_SCRIPT_DEBUG_UI_H
+#define MOONRAY_SCRIPT_DEBUG_UI_H
+
+#include "raylib.h"
+#include "Imgui/imgui.h"
+#include "MoonRay/ScriptTelemetry.h"
+#include "MoonRay/ScriptProfiler.h"
+#include <algorithm>
+#include <string>
+#include <cfloat>
+#include <cstdint>
+
+namespace MoonRay {
+    inline void DrawScriptDebugWindow(int toggleKey = KEY_F3) {
+        static bool open = false;
+        if (IsKeyPressed(toggleKey)) open = !open;
+
+        ScriptTelemetry& telemetry = ScriptTelemetry::Get();
+        telemetry.Enable(open);
+        if (!open) return;
+
+        ImGui::Begin("Lua VMs", &open);
+        for (const auto& entry : telemetry.Snapshot()) {
+            const ScriptGCStats& gc = entry.gc;
+            ImGui::PushID((int)entry.vm);
+            ImGui::Text("VM %llu: heap %zu KB (peak %zu, pools %zu), %llu GC cycles", (unsigned long long)entry.vm, gc.heapKB, gc.peakKB,
+                        gc.reservedKB, (unsigned long long)gc.cycles);
+            if (gc.budgetOverruns > 0) ImGui::TextColored(ImVec4(1.0f, 0.4f, 0.3f, 1.0f), "%llu script calls over budget", (unsigned long long)gc.budgetOverruns);
+            if (gc.limitKB > 0) {
+                ImGui::Text("Limit %zu KB, %llu allocations refused", gc.limitKB, (unsigned long long)gc.failedAllocations);
+            }
+            if (gc.budgetUs > 0) {
+                ImGui::Text("GC %.0f us (avg %.0f, max %.0f), budget %d us x%d", gc.lastStepUs, gc.avgStepUs, gc.maxStepUs, gc.budgetUs, gc.boost);
+            } else {
+                ImGui::Text("GC: automatic");
+            }
+
+            float maxStep = std::max(1.0f, *std::max_element(entry.stepHistory.begin(), entry.stepHistory.end()));
+            ImGui::PlotLines("heap KB", entry.heapHistory.data(), (int)entry.heapHistory.size(), 0, nullptr, 0.0f, FLT_MAX, ImVec2(0, 40));
+            ImGui::PlotHistogram("GC us", entry.stepHistory.data(), (int)entry.stepHistory.size(), 0, nullptr, 0.0f, maxStep, ImVec2(0, 40));
+            ImGui::Separator();
+            ImGui::PopID();
+        }
+        ImGui::End();
+    }
+
+    // One row per call depth, root at the top; width is time including callees. Returns the
+    // node clicked this frame, -1 if none.
+    inline int DrawFlameNode(const ScriptProfiler::Report& report, int node, ImVec2 origin, float x, float width, int depth) {
+        const float rowHeight = ImGui::GetTextLineHeight() + 4.0f;
+        if (width < 1.0f) return -1;
+
+        const ScriptProfiler::Node& n = report.nodes[node];
+        const std::string& name = n.frame >= 0 ? report.frames[n.frame] : std::string("all scripts");
+        ImVec2 min(origin.x + x, origin.y + depth * rowHeight);
+        ImVec2 max(min.x + width - 1.0f, min.y + rowHeight - 1.0f);
+
+        uint32_t hash = 2166136261u;
+        for (char c : name) hash = (hash ^ (uint8_t)c) * 16777619u;
+        ImU32 color = IM_COL32(200 + hash % 55, 80 + (hash >> 8) % 120, 40 + (hash >> 16) % 40, 255);
+
+        ImDrawList* draw = ImGui::GetWindowDrawList();
+        draw->AddRectFilled(min, max, color);
+        if (width > 30.0f) {
+            draw->PushClipRect(min, max, true);
+            draw->AddText(ImVec2(min.x + 3.0f, min.y + 2.0f), IM_COL32(20, 20, 20, 255), name.c_str());
+            draw->PopClipRect();
+        }
+
+        int clicked = -1;
+        if (ImGui::IsMouseHoveringRect(min, max)) {
+            double all = std::max(report.nodes[0].totalUs, 1.0);
+            ImGui::SetTooltip("%s\ntotal %.2f ms (%.1f%%)\nself %.2f ms (%.1f%%)\n%llu samples", name.c_str(), n.totalUs / 1000.0,
+                              n.totalUs * 100.0 / all, n.selfUs / 1000.0, n.selfUs * 100.0 / all, (unsigned long long)n.samples);
+            if (ImGui::IsMouseClicked(0)) clicked = node;
+        }
+
+        float childX = x;
+        for (int child : n.children) {
+            float childWidth = (float)(width * report.nodes[child].totalUs / std::max(n.totalUs, 1e-9));
+            int result = DrawFlameNode(report, child, origin, childX, childWidth, depth + 1);
+            if (result >= 0) clicked = result;
+            childX += childWidth;
+        }
+        return clicked;
+    }
+
+    inline void DrawScriptProfilerWindow(int toggleKey = KEY_F4) {
+        static bool open = false;
+        static int interval = 100;
+        static int zoom = 0;
+        static double lastSnapshot = -1.0;
+        static ScriptProfiler::Report report;
+        static std::string exportStatus;
+        if (IsKeyPressed(toggleKey)) open = !open;
+        if (!open) return;
+
+        ScriptProfiler& profiler = ScriptProfiler::Get();
+        ImGui::Begin("Lua Profiler", &open);
+
+        if (profiler.Running()) {
+            if (ImGui::Button("Stop")) profiler.Stop();
+        } else {
+            if (ImGui::Button("Start")) profiler.Start(interval);
+        }
+        ImGui::SameLine();
+        if (ImGui::Button("Clear")) {
+            profiler.Clear();
+            zoom = 0;
+            lastSnapshot = -1.0;
+        }
+        ImGui::SameLine();
+        if (ImGui::Button("Export")) {
+            exportStatus = profiler.Export("lua_profile.folded") ? "Saved lua_profile.folded" : "Can't write lua_profile.folded";
+        }
+        ImGui::SameLine();
+        ImGui::SetNextItemWidth(120.0f);
+        ImGui::SliderInt("interval us", &interval, 20, 1000);
+        if (!exportStatus.empty()) ImGui::TextUnformatted(exportStatus.c_str());
+
+        // A snapshot copies the whole tree, twice a second is enough to watch it grow
+        if (lastSnapshot < 0.0 || GetTime() - lastSnapshot > 0.5) {
+            report = profiler.Snapshot();
+            lastSnapshot = GetTime();
+            if (zoom >= (int)report.nodes.size()) zoom = 0;
+        }
+        ImGui::Text("%.1f ms of script time, %llu samples", report.nodes[0].totalUs / 1000.0, (unsigned long long)report.nodes[0].samples);
+
+        if (zoom != 0) {
+            ImGui::SameLine();
+            if (ImGui::Button("Reset zoom")) zoom = 0;
+        }
+
+        // Ancestors of the zoomed node stay on the rows above it at full width
+        int depth = 0;
+        for (int node = report.nodes[zoom].parent; node >= 0; node = report.nodes[node].parent) depth++;
+
+        float width = ImGui::GetContentRegionAvail().x;
+        ImVec2 origin = ImGui::GetCursorScreenPos();
+        for (int node = report.nodes[zoom].parent, row = depth - 1; node >= 0; node = report.nodes[node].parent, row--) {
+            ImVec2 min(origin.x, origin.y + row * (ImGui::GetTextLineHeight() + 4.0f));
+            ImVec2 max(origin.x + width - 1.0f, min.y + ImGui::GetTextLineHeight() + 3.0f);
+            ImGui::GetWindowDrawList()->AddRectFilled(min, max, IM_COL32(90, 90, 90, 255));
+            const std::string& name = report.nodes[node].frame >= 0 ? report.frames[report.nodes[node].frame] : std::string("all scripts");
+            ImGui::GetWindowDrawList()->AddText(ImVec2(min.x + 3.0f, min.y + 2.0f), IM_COL32(230, 230, 230, 255), name.c_str());
+            if (ImGui::IsMouseHoveringRect(min, max) && ImGui::IsMouseClicked(0)) zoom = node;
+        }
+
+        int clicked = DrawFlameNode(report, zoom, origin, 0.0f, width, depth);
+        if (clicked >= 0) zoom = clicked;
+
+        int maxDepth = depth;
+        for (size_t i = 0; i < report.nodes.size(); i++) {
+            int d = 0;
+            for (int node = report.nodes[i].parent; node >= 0; node = report.nodes[node].parent) d++;
+            maxDepth = std::max(maxDepth, d);
+        }
+        ImGui::Dummy(ImVec2(width, (maxDepth + 1) * (ImGui::GetTextLineHeight() + 4.0f)));
+
+        if (ImGui::CollapsingHeader("Hottest lines", ImGuiTreeNodeFlags_DefaultOpen)) {
+            double all = std::max(report.nodes[0].totalUs, 1.0);
+            for (size_t i = 0; i < report.lines.size() && i < 20; i++) {
+                const ScriptProfiler::Line& line = report.lines[i];
+                ImGui::Text("%6.2f ms %5.1f%%  %s:%d", line.selfUs / 1000.0, line.selfUs * 100.0 / all, line.source.c_str(), line.line);
+            }
+        }
+        ImGui::End();
+    }
+}
+
+#endif
@@ -0,0 +1,135 @@
+/*
+ * Copyright (C) 2026 Artem Svitlov (Moscow, Russia)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// Messages between script VMs. VMs share no Lua values, so broadcast(name, ...) copies its
+// arguments into a byte string: nil, booleans, numbers, strings and tables of those (nested,
+// without cycles). Userdata, functions and coroutines can't be sent.
+
+#ifndef MOONRAY_SCRIPT_MESSAGES_H
+#define MOONRAY_SCRIPT_MESSAGES_H
+
+#include "lua.hpp"
+#include <string>
+#include <cstring>
+#include <cstdint>
+
+namespace MoonRay {
+    struct ScriptMessage {
+        std::string name;
+        std::string data;   // Encoded arguments
+        int count = 0;      // Number of arguments
+    };
+
+    namespace Messages {
+        constexpr int MaxDepth = 16;
+
+        enum Tag : char { Nil = 'n', False = 'f', True = 't', Integer = 'i', Number = 'd', String = 's', Table = 'T', End = 'e' };
+
+        template <typename T>
+        inline void Append(std::string& out, T value) {
+            out.append(reinterpret_cast<const char*>(&value), sizeof(T));
+        }
+
+        template <typename T>
+        inline T Read(const std::string& in, size_t& at) {
+            T value;
+            memcpy(&value, in.data() + at, sizeof(T));
+            at += sizeof(T);
+            return value;
+        }
+
+        // Appends the value at index; raises a Lua error for values that can't be copied
+        inline void Encode(lua_State* L, int index, std::string& out, int depth = 0) {
+            index = lua_absindex(L, index);
+            switch (lua_type(L, index)) {
+            case LUA_TNIL:
+                out += Nil;
+                break;
+            case LUA_TBOOLEAN:
+                out += lua_toboolean(L, index) ? True : False;
+                break;
+            case LUA_TNUMBER:
+                if (lua_isinteger(L, index)) {
+                    out += Integer;
+                    Append<lua_Integer>(out, lua_tointeger(L, index));
+                } else {
+                    out += Number;
+                    Append<lua_Number>(out, lua_tonumber(L, index));
+                }
+                break;
+            case LUA_TSTRING: {
+                size_t length;
+                const char* text = lua_tolstring(L, index, &length);
+                out += String;
+                Append<uint32_t>(out, (uint32_t)length);
+                out.append(text, length);
+                break;
+            }
+            case LUA_TTABLE:
+                if (depth >= MaxDepth) luaL_error(L, "broadcast: tables nested deeper than %d levels (cycle?)", MaxDepth);
+                luaL_checkstack(L, 3, nullptr);
+                out += Table;
+                lua_pushnil(L);
+                while (lua_next(L, index)) {
+                    Encode(L, -2, out, depth + 1);
+                    Encode(L, -1, out, depth + 1);
+                    lua_pop(L, 1);
+                }
+                out += End;
+                break;
+            default:
+                luaL_error(L, "broadcast: can't send a %s", luaL_typename(L, index));
+            }
+        }
+
+        // Pushes the value at `at` and advances past it
+        inline void Decode(lua_State* L, const std::string& in, size_t& at) {
+            luaL_checkstack(L, 2, nullptr);
+            switch (in[at++]) {
+            case False: lua_pushboolean(L, 0); break;
+            case True: lua_pushboolean(L, 1); break;
+            case Integer: lua_pushinteger(L, Read<lua_Integer>(in, at)); break;
+            case Number: lua_pushnumber(L, Read<lua_Number>(in, at)); break;
+            case String: {
+                uint32_t length = Read<uint32_t>(in, at);
+                lua_pushlstring(L, in.data() + at, length);
+                at += length;
+                break;
+            }
+            case Table:
+                lua_newtable(L);
+                while (in[at] != End) {
+                    Decode(L, in, at);
+                    Decode(L, in, at);
+                    lua_rawset(L, -3);
+                }
+                at++;
+                break;
+            default: lua_pushnil(L); break;
+            }
+        }
+
+        // Pushes the message's arguments, returns how many
+        inline int Push(lua_State* L, const ScriptMessage& message) {
+            size_t at = 0;
+            for (int i = 0; i < message.count; i++) Decode(L, message.data, at);
+            return message.count;
+        }
+    }
+}
+
+#endif
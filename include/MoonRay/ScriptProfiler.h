@@ -0,0 +1,221 @@
+/*
+ * Copyright (C) 2026 Artem Svitlov (Moscow, Russia)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// Sampling profiler for Lua scripts, shared by every ScriptVM. While it runs, each VM installs a
+// count hook (see ScriptVM::UpdateHook) that checks the clock every HookInstructions VM
+// instructions and takes a sample once Interval() microseconds of script time have passed. A
+// sample walks the Lua stack and adds the elapsed time to that call path, so the results are
+// script time per function (file:line where it is defined) and per source line, summed over
+// every instance and VM. Time spent in C functions is charged to the Lua line that called them.
+//
+// Results are a call tree for the flame view (DrawScriptProfilerWindow) and can be exported in
+// the folded stack format ("a;b;c 1234" per line, microseconds) read by flamegraph.pl and
+// speedscope.
+
+#ifndef MOONRAY_SCRIPT_PROFILER_H
+#define MOONRAY_SCRIPT_PROFILER_H
+
+#include "lua.hpp"
+#include <mutex>
+#include <atomic>
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <algorithm>
+#include <fstream>
+#include <cstdlib>
+#include <cstdint>
+
+namespace MoonRay {
+    class ScriptProfiler {
+    public:
+        static constexpr int HookInstructions = 1000;
+
+        struct Node {
+            int frame = -1;             // Index into Frames(), -1 for the root
+            int parent = -1;
+            std::vector<int> children;
+            double totalUs = 0.0;       // Including callees
+            double selfUs = 0.0;
+            uint64_t samples = 0;
+        };
+
+        struct Line {
+            std::string source;
+            int line = 0;
+            double selfUs = 0.0;
+            uint64_t samples = 0;
+        };
+
+        struct Report {
+            std::vector<std::string> frames;    // "name (file:line)"
+            std::vector<Node> nodes;            // nodes[0] is the root, its totalUs is all sampled time
+            std::vector<Line> lines;            // Hottest first
+        };
+
+    private:
+        std::mutex mutex;
+        std::atomic<bool> running{ false };
+        std::atomic<uint64_t> generation{ 0 };  // Bumped on Start/Stop, VMs compare it once per call
+        std::atomic<int> intervalUs{ 100 };
+
+        std::vector<std::string> frames;
+        std::unordered_map<std::string, int> frameIds;
+        std::vector<Node> nodes = std::vector<Node>(1);
+        std::unordered_map<uint64_t, int> edges;            // parent << 32 | frame -> node
+        std::unordered_map<std::string, Line> lines;        // "file:line"
+
+        int FrameId(const std::string& key, const lua_Debug& ar) {
+            auto it = frameIds.find(key);
+            if (it != frameIds.end()) return it->second;
+
+            std::string name;
+            if (*ar.what == 'm') name = "main chunk";
+            else if (*ar.what == 'C') name = ar.name ? ar.name : "?";
+            else name = ar.name ? ar.name : "function";
+            if (*ar.what != 'C') name += " (" + std::string(ar.short_src) + ":" + std::to_string(ar.linedefined) + ")";
+            else name = "[C] " + name;
+
+            int id = (int)frames.size();
+            frames.push_back(name);
+            frameIds.emplace(key, id);
+            return id;
+        }
+
+        int Child(int parent, int frame) {
+            uint64_t edge = (uint64_t)parent << 32 | (uint32_t)frame;
+            auto it = edges.find(edge);
+            if (it != edges.end()) return it->second;
+
+            int id = (int)nodes.size();
+            nodes.emplace_back();
+            nodes[id].frame = frame;
+            nodes[id].parent = parent;
+            nodes[parent].children.push_back(id);
+            edges.emplace(edge, id);
+            return id;
+        }
+
+        void Fold(const Report& report, int node, std::string& path, std::ofstream& out) const {
+            const Node& n = report.nodes[node];
+            size_t length = path.size();
+            if (n.frame >= 0) {
+                if (!path.empty()) path += ';';
+                std::string name = report.frames[n.frame];
+                std::replace(name.begin(), name.end(), ';', ',');
+                path += name;
+                if (n.selfUs >= 1.0) out << path << ' ' << (uint64_t)n.selfUs << '\n';
+            }
+            for (int child : n.children) Fold(report, child, path, out);
+            path.resize(length);
+        }
+
+    public:
+        static ScriptProfiler& Get() {
+            static ScriptProfiler profiler;
+            return profiler;
+        }
+
+        void Start(int sampleIntervalUs = 100) {
+            intervalUs = std::max(1, sampleIntervalUs);
+            running = true;
+            generation++;
+        }
+
+        void Stop() {
+            running = false;
+            generation++;
+        }
+
+        bool Running() const { return running.load(std::memory_order_relaxed); }
+        uint64_t Generation() const { return generation.load(std::memory_order_relaxed); }
+        int Interval() const { return intervalUs.load(std::memory_order_relaxed); }
+
+        void Clear() {
+            std::lock_guard<std::mutex> lock(mutex);
+            frames.clear();
+            frameIds.clear();
+            nodes.assign(1, Node());
+            edges.clear();
+            lines.clear();
+        }
+
+        // Called from a count hook: charges elapsedUs to the Lua call stack of state
+        void Sample(lua_State* state, double elapsedUs) {
+            lua_Debug ar;
+            std::vector<std::string> keys;
+            std::vector<lua_Debug> stack;
+            std::string line;
+            for (int level = 0; lua_getstack(state, level, &ar); level++) {
+                lua_getinfo(state, "Snl", &ar);
+                if (*ar.what == 'C' && !ar.name) continue;     // pcall and engine entry points
+                if (*ar.what == 'C') keys.push_back(std::string("[C]") + ar.name);
+                else keys.push_back(std::string(ar.source) + ":" + std::to_string(ar.linedefined));
+                if (line.empty() && *ar.what != 'C') line = std::string(ar.short_src) + ":" + std::to_string(ar.currentline);
+                stack.push_back(ar);
+            }
+            if (stack.empty()) return;
+
+            std::lock_guard<std::mutex> lock(mutex);
+            int node = 0;
+            nodes[0].totalUs += elapsedUs;
+            nodes[0].samples++;
+            for (size_t i = stack.size(); i-- > 0;) {
+                node = Child(node, FrameId(keys[i], stack[i]));
+                nodes[node].totalUs += elapsedUs;
+                nodes[node].samples++;
+            }
+            nodes[node].selfUs += elapsedUs;
+
+            if (!line.empty()) {
+                Line& hot = lines[line];
+                if (hot.samples == 0) {
+                    size_t colon = line.rfind(':');
+                    hot.source = line.substr(0, colon);
+                    hot.line = atoi(line.c_str() + colon + 1);
+                }
+                hot.selfUs += elapsedUs;
+                hot.samples++;
+            }
+        }
+
+        Report Snapshot() {
+            Report report;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                report.frames = frames;
+                report.nodes = nodes;
+                report.lines.reserve(lines.size());
+                for (const auto& entry : lines) report.lines.push_back(entry.second);
+            }
+            std::sort(report.lines.begin(), report.lines.end(), [](const Line& a, const Line& b) { return a.selfUs > b.selfUs; });
+            return report;
+        }
+
+        // Writes the folded stacks to path, false if the file can't be written
+        bool Export(const std::string& path) {
+            std::ofstream out(path, std::ios::trunc);
+            if (!out) return false;
+            Report report = Snapshot();
+            std::string stack;
+            Fold(report, 0, stack, out);
+            return (bool)out;
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,380 @@
+/*
+ * Copyright (C) 2026 Artem Svitlov (Moscow, Russia)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// Coroutines run by the engine, one scheduler per ScriptVM. Lua side:
+//
+//   local co = startCoroutine(fn, ...)   -- runs fn until its first wait, returns a handle
+//   stopCoroutine(co)                    -- no argument: the calling coroutine
+//   wait(seconds)  waitFrames(n)  waitUntil("event")  waitUntil(function() return ready end)
+//   signal("event", ...)                 -- resumes every waitUntil("event"), which returns ...
+//
+// Sleeping coroutines sit in min-heaps keyed by wake time or frame, and event waiters in a list
+// per event, so a tick only touches coroutines that are due. waitUntil(function) is the
+// exception: the predicate is called every tick. A plain coroutine.yield() waits one frame.
+
+#ifndef MOONRAY_SCRIPT_SCHEDULER_H
+#define MOONRAY_SCRIPT_SCHEDULER_H
+
+#include "lua.hpp"
+#include "MoonRay/ScriptWatchdog.h"
+#include <string>
+#include <vector>
+#include <queue>
+#include <functional>
+#include <unordered_map>
+#include <algorithm>
+#include <cstring>
+#include <cstdint>
+#include <iostream>
+
+namespace MoonRay {
+    class ScriptScheduler {
+    private:
+        enum class Wait { None, Time, Frames, Event, Predicate };
+
+        struct Task {
+            lua_State* thread = nullptr;
+            int ref = LUA_NOREF;            // Registry ref to the thread, keeps it alive
+            int predicate = LUA_NOREF;      // waitUntil(function)
+            std::string event;              // waitUntil("event")
+            const void* owner = nullptr;    // Environment of the script instance that started it
+            Wait wait = Wait::None;
+            double wakeTime = 0.0;
+            uint64_t wakeFrame = 0;
+            uint64_t serial = 0;            // Bumped per wait; heap and list entries of older waits are stale
+            bool active = false;            // Being resumed (possibly resuming another coroutine)
+            bool stopped = false;           // stopCoroutine() while active, removed when it yields
+        };
+
+        struct Entry {
+            double key;
+            uint64_t id;
+            uint64_t serial;
+            bool operator>(const Entry& other) const { return key > other.key; }
+        };
+        using Heap = std::priority_queue<Entry, std::vector<Entry>, std::greater<Entry>>;
+
+        std::unordered_map<uint64_t, Task> tasks;
+        std::unordered_map<lua_State*, uint64_t> threads;  // Coroutine -> task, wait() finds its caller here
+        std::unordered_map<const void*, std::vector<uint64_t>> owned;
+        Heap timers;                                        // By wake time
+        Heap frameTimers;                                   // By wake frame
+        std::unordered_map<std::string, std::vector<Entry>> events;
+        std::vector<Entry> polling;                         // waitUntil(function)
+        std::vector<Entry> due;
+        double now = 0.0;                                   // Sum of the ticks' dt
+        uint64_t frame = 0;
+        uint64_t nextId = 1;
+        ScriptWatchdog::Slot* watchdog = nullptr;           // Told which thread runs, see Resume
+
+        static ScriptScheduler* Self(lua_State* L) {
+            return static_cast<ScriptScheduler*>(lua_touserdata(L, lua_upvalueindex(1)));
+        }
+
+        bool Valid(const Entry& entry) const {
+            auto it = tasks.find(entry.id);
+            return it != tasks.end() && it->second.serial == entry.serial && !it->second.stopped;
+        }
+
+        // Task of the running coroutine, raises a Lua error outside of one
+        Task& Current(lua_State* L, const char* function) {
+            auto it = threads.find(L);
+            if (it == threads.end()) luaL_error(L, "%s: not inside a coroutine started with startCoroutine", function);
+            return tasks[it->second];
+        }
+
+        void Remove(lua_State* L, uint64_t id) {
+            auto it = tasks.find(id);
+            if (it == tasks.end()) return;
+            threads.erase(it->second.thread);
+            auto owner = owned.find(it->second.owner);
+            if (owner != owned.end()) {
+                std::vector<uint64_t>& ids = owner->second;
+                ids.erase(std::remove(ids.begin(), ids.end(), id), ids.end());
+                if (ids.empty()) owned.erase(owner);
+            }
+            // A waitUntil("event") entry would otherwise stay until the event is signalled
+            if (it->second.wait == Wait::Event) {
+                auto waiting = events.find(it->second.event);
+                if (waiting != events.end()) {
+                    std::vector<Entry>& entries = waiting->second;
+                    entries.erase(std::remove_if(entries.begin(), entries.end(), [id](const Entry& entry) { return entry.id == id; }), entries.end());
+                    if (entries.empty()) events.erase(waiting);
+                }
+            }
+            luaL_unref(L, LUA_REGISTRYINDEX, it->second.predicate);
+            luaL_unref(L, LUA_REGISTRYINDEX, it->second.ref);
+            tasks.erase(it);
+        }
+
+        void Stop(lua_State* L, uint64_t id) {
+            auto it = tasks.find(id);
+            if (it == tasks.end()) return;
+            if (it->second.active) it->second.stopped = true;
+            else Remove(L, id);
+        }
+
+        // Files the yielded task under what it waits for
+        void Schedule(uint64_t id, Task& task) {
+            Entry entry{ 0.0, id, ++task.serial };
+            switch (task.wait) {
+            case Wait::Time:
+                entry.key = task.wakeTime;
+                timers.push(entry);
+                break;
+            case Wait::Predicate:
+                polling.push_back(entry);
+                break;
+            case Wait::Event:
+                events[task.event].push_back(entry);
+                break;
+            default:
+                task.wait = Wait::Frames;
+                task.wakeFrame = std::max(task.wakeFrame, frame + 1);
+                entry.key = (double)task.wakeFrame;
+                frameTimers.push(entry);
+                break;
+            }
+        }
+
+        // Resumes the task; its nargs arguments are already on the thread's stack
+        void Resume(lua_State* from, uint64_t id, int nargs) {
+            lua_State* thread;
+            {
+                Task& task = tasks[id];
+                thread = task.thread;
+                task.active = true;
+                task.wait = Wait::None;
+                task.wakeFrame = 0;
+                luaL_unref(from, LUA_REGISTRYINDEX, task.predicate);
+                task.predicate = LUA_NOREF;
+            }
+
+            lua_State* previous = watchdog ? watchdog->Switch(thread) : nullptr;
+            int status = lua_resume(thread, from, nargs);
+            if (watchdog) watchdog->Switch(previous);
+
+            // Looked up again: the coroutine may have started others (rehash). Stop() defers
+            // removal of active tasks, so it is still there.
+            Task& task = tasks[id];
+            task.active = false;
+            if (status == LUA_YIELD && !task.stopped) {
+                lua_settop(thread, 0);
+                Schedule(id, task);
+                return;
+            }
+            if (status != LUA_OK && status != LUA_YIELD) {
+                const char* message = lua_tostring(thread, -1);
+                luaL_traceback(from, thread, message ? message : "(non-string error)", 0);
+                std::cerr << "LUA ERROR: " << lua_tostring(from, -1) << std::endl;
+                lua_pop(from, 1);
+            }
+            Remove(from, id);
+        }
+
+        static int l_startCoroutine(lua_State* L) {
+            ScriptScheduler* self = Self(L);
+            luaL_checktype(L, 1, LUA_TFUNCTION);
+            int n = lua_gettop(L);
+
+            // Owned by the instance whose code defined fn, or failing that, whose code called us
+            const void* owner = EnvironmentOf(L, 1);
+            lua_Debug ar;
+            if (!owner && lua_getstack(L, 1, &ar) && lua_getinfo(L, "f", &ar)) {
+                owner = EnvironmentOf(L, -1);
+                lua_pop(L, 1);
+            }
+
+            lua_State* thread = lua_newthread(L);
+            lua_insert(L, 1);
+            lua_xmove(L, thread, n);
+            int ref = luaL_ref(L, LUA_REGISTRYINDEX);
+
+            uint64_t id = self->nextId++;
+            Task& task = self->tasks[id];
+            task.thread = thread;
+            task.ref = ref;
+            task.owner = owner;
+            self->threads[thread] = id;
+            if (owner) self->owned[owner].push_back(id);
+
+            // fn and its arguments are on the thread's stack
+            self->Resume(L, id, n - 1);
+
+            lua_pushinteger(L, (lua_Integer)id);
+            return 1;
+        }
+
+        static int l_stopCoroutine(lua_State* L) {
+            ScriptScheduler* self = Self(L);
+            if (lua_isnoneornil(L, 1)) {
+                Task& task = self->Current(L, "stopCoroutine");
+                task.stopped = true;
+                return lua_yield(L, 0);
+            }
+            self->Stop(L, (uint64_t)luaL_checkinteger(L, 1));
+            return 0;
+        }
+
+        static int l_wait(lua_State* L) {
+            ScriptScheduler* self = Self(L);
+            Task& task = self->Current(L, "wait");
+            task.wait = Wait::Time;
+            task.wakeTime = self->now + luaL_optnumber(L, 1, 0.0);
+            return lua_yield(L, 0);
+        }
+
+        static int l_waitFrames(lua_State* L) {
+            ScriptScheduler* self = Self(L);
+            Task& task = self->Current(L, "waitFrames");
+            lua_Integer n = luaL_optinteger(L, 1, 1);
+            task.wait = Wait::Frames;
+            task.wakeFrame = self->frame + (uint64_t)(n > 1 ? n : 1);
+            return lua_yield(L, 0);
+        }
+
+        static int l_waitUntil(lua_State* L) {
+            ScriptScheduler* self = Self(L);
+            Task& task = self->Current(L, "waitUntil");
+            if (lua_isfunction(L, 1)) {
+                lua_pushvalue(L, 1);
+                task.predicate = luaL_ref(L, LUA_REGISTRYINDEX);
+                task.wait = Wait::Predicate;
+            } else {
+                task.event = luaL_checkstring(L, 1);
+                task.wait = Wait::Event;
+            }
+            return lua_yield(L, 0);
+        }
+
+        static int l_signal(lua_State* L) {
+            std::string name = luaL_checkstring(L, 1);
+            lua_pushinteger(L, (lua_Integer)Self(L)->Signal(L, name, 2, lua_gettop(L) - 1));
+            return 1;
+        }
+
+        void RegisterFunction(lua_State* L, const char* name, lua_CFunction function) {
+            lua_pushlightuserdata(L, this);
+            lua_pushcclosure(L, function, 1);
+            lua_setglobal(L, name);
+        }
+
+    public:
+        ScriptScheduler() = default;
+        ScriptScheduler(const ScriptScheduler&) = delete;
+        ScriptScheduler& operator=(const ScriptScheduler&) = delete;
+
+        // Environment of the script instance that defined the function at index (its _ENV
+        // upvalue), nullptr if it has none
+        static const void* EnvironmentOf(lua_State* L, int index) {
+            const void* env = nullptr;
+            for (int i = 1; const char* name = lua_getupvalue(L, index, i); i++) {
+                if (strcmp(name, "_ENV") == 0 && lua_istable(L, -1)) env = lua_topointer(L, -1);
+                lua_pop(L, 1);
+                if (env) break;
+            }
+            return env;
+        }
+
+        void Register(lua_State* L) {
+            RegisterFunction(L, "startCoroutine", l_startCoroutine);
+            RegisterFunction(L, "stopCoroutine", l_stopCoroutine);
+            RegisterFunction(L, "wait", l_wait);
+            RegisterFunction(L, "waitFrames", l_waitFrames);
+            RegisterFunction(L, "waitUntil", l_waitUntil);
+            RegisterFunction(L, "signal", l_signal);
+        }
+
+        void SetWatchdog(ScriptWatchdog::Slot* slot) { watchdog = slot; }
+
+        bool Empty() const { return tasks.empty(); }
+        size_t Count() const { return tasks.size(); }
+
+        // Advances the scheduler clock by dt and one frame, then resumes what is due.
+        // beforeResume runs before each of those resumes.
+        void Tick(lua_State* L, float dt, const std::function<void()>& beforeResume = nullptr) {
+            now += dt;
+            frame++;
+
+            due.clear();
+            while (!timers.empty() && timers.top().key <= now) {
+                if (Valid(timers.top())) due.push_back(timers.top());
+                timers.pop();
+            }
+            while (!frameTimers.empty() && frameTimers.top().key <= (double)frame) {
+                if (Valid(frameTimers.top())) due.push_back(frameTimers.top());
+                frameTimers.pop();
+            }
+
+            size_t kept = 0;
+            for (size_t i = 0; i < polling.size(); i++) {
+                Entry entry = polling[i];
+                if (!Valid(entry)) continue;
+                if (beforeResume) beforeResume();
+                lua_rawgeti(L, LUA_REGISTRYINDEX, tasks[entry.id].predicate);
+                if (lua_pcall(L, 0, 1, 0) != LUA_OK) {
+                    std::cerr << "LUA ERROR: " << lua_tostring(L, -1) << std::endl;
+                    lua_pop(L, 1);
+                    Remove(L, entry.id);
+                    continue;
+                }
+                bool ready = lua_toboolean(L, -1);
+                lua_pop(L, 1);
+                if (ready) due.push_back(entry);
+                else polling[kept++] = entry;
+            }
+            polling.resize(kept);
+
+            for (const Entry& entry : due) {
+                if (!Valid(entry)) continue;
+                if (beforeResume) beforeResume();
+                Resume(L, entry.id, 0);
+            }
+        }
+
+        // Resumes every waitUntil(name) with the nargs values starting at stack index first.
+        // Returns how many were woken.
+        int Signal(lua_State* L, const std::string& name, int first, int nargs) {
+            auto it = events.find(name);
+            if (it == events.end()) return 0;
+            std::vector<Entry> waiting;
+            waiting.swap(it->second);
+            events.erase(it);
+
+            int woken = 0;
+            for (const Entry& entry : waiting) {
+                if (!Valid(entry)) continue;
+                lua_State* thread = tasks[entry.id].thread;
+                for (int i = first; i < first + nargs; i++) lua_pushvalue(L, i);
+                lua_xmove(L, thread, nargs);
+                Resume(L, entry.id, nargs);
+                woken++;
+            }
+            return woken;
+        }
+
+        // Stops the coroutines started by a script instance (its environment table)
+        void StopOwner(lua_State* L, const void* owner) {
+            auto it = owned.find(owner);
+            if (it == owned.end()) return;
+            std::vector<uint64_t> ids = it->second;
+            for (uint64_t id : ids) Stop(L, id);
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,211 @@
+/*
+ * Copyright (C) 2026 Artem Svitlov (Moscow, Russia)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// Lua systems, one registry per ScriptVM. A system is a function that processes every
+// GameObject matching a component query, a batch at a time, instead of one OnUpdate per entity:
+//
+//   registerSystem("drift", { "transform" }, function(dt, count, transform)
+//       for i = 0, count - 1 do
+//           local x = i * 10 + 1                 -- 10 floats per transform, see LuaComponent.h
+//           transform[x] = transform[x] + dt
+//       end
+//   end)
+//   removeSystem("drift")
+//
+// The scene packs the queried components of up to BatchSize objects into one buffer per query
+// entry, calls the function with FloatArray views over them and writes the floats back
+// (Scene::RunSystems). Registering a name again replaces the system, so hot reloads don't
+// duplicate it. A system goes away with the script instance that defined its function.
+
+#ifndef MOONRAY_SCRIPT_SYSTEMS_H
+#define MOONRAY_SCRIPT_SYSTEMS_H
+
+#include "lua.hpp"
+#include "MoonRay/MoonRayLua.h"
+#include "MoonRay/ScriptScheduler.h"
+#include <string>
+#include <vector>
+#include <algorithm>
+#include <cstring>
+
+namespace MoonRay {
+    class ScriptSystems {
+    public:
+        enum ComponentType { Transform, Transform2D, ComponentTypeCount };
+
+        static constexpr size_t BatchSize = 1024;
+
+        struct System {
+            std::string name;
+            std::vector<ComponentType> query;
+            int function = LUA_NOREF;
+            std::vector<int> views;         // FloatArray view per query entry, pointed at each batch
+            const void* owner = nullptr;    // Environment of the instance that defined the function
+            bool removed = false;           // Erased by Compact()
+        };
+
+        // Query names, the same as the views scripts get of their own components
+        static const char* ComponentName(ComponentType type) {
+            static const char* const names[] = { "transform", "transform2D" };
+            return names[type];
+        }
+
+    private:
+        std::vector<System> systems;
+
+        static ScriptSystems* Self(lua_State* L) {
+            return static_cast<ScriptSystems*>(lua_touserdata(L, lua_upvalueindex(1)));
+        }
+
+        System* Find(const char* name) {
+            for (auto& system : systems) {
+                if (!system.removed && system.name == name) return &system;
+            }
+            return nullptr;
+        }
+
+        // Empties the views first: a script may still hold one
+        static void ReleaseViews(lua_State* L, System& system) {
+            for (int ref : system.views) {
+                lua_rawgeti(L, LUA_REGISTRYINDEX, ref);
+                ClearFloatView(static_cast<FloatArray*>(lua_touserdata(L, -1)));
+                lua_pop(L, 1);
+                luaL_unref(L, LUA_REGISTRYINDEX, ref);
+            }
+            system.views.clear();
+        }
+
+        static void Release(lua_State* L, System& system) {
+            ReleaseViews(L, system);
+            luaL_unref(L, LUA_REGISTRYINDEX, system.function);
+            system.function = LUA_NOREF;
+            system.removed = true;
+        }
+
+        // registerSystem(name, { component, ... }, fn). Checked before any C++ object exists,
+        // luaL_error doesn't unwind.
+        static int l_registerSystem(lua_State* L) {
+            ScriptSystems* self = Self(L);
+            const char* name = luaL_checkstring(L, 1);
+            luaL_checktype(L, 2, LUA_TTABLE);
+            luaL_checktype(L, 3, LUA_TFUNCTION);
+
+            ComponentType query[ComponentTypeCount];
+            size_t size = 0;
+            for (lua_Integer i = 1; lua_rawgeti(L, 2, i) != LUA_TNIL; i++) {
+                const char* component = lua_tostring(L, -1);
+                int type = 0;
+                while (type < ComponentTypeCount && (!component || strcmp(component, ComponentName((ComponentType)type)) != 0)) type++;
+                if (type == ComponentTypeCount) return luaL_error(L, "registerSystem: unknown component '%s'", component ? component : "?");
+                if (std::find(query, query + size, (ComponentType)type) != query + size) {
+                    return luaL_error(L, "registerSystem: '%s' is queried twice", component);
+                }
+                query[size++] = (ComponentType)type;
+                lua_pop(L, 1);
+            }
+            lua_pop(L, 1);
+            luaL_argcheck(L, size > 0, 2, "no components");
+
+            System* system = self->Find(name);
+            if (system) {
+                ReleaseViews(L, *system);
+                luaL_unref(L, LUA_REGISTRYINDEX, system->function);
+            } else {
+                self->systems.emplace_back();
+                system = &self->systems.back();
+                system->name = name;
+            }
+            system->query.assign(query, query + size);
+            system->owner = ScriptScheduler::EnvironmentOf(L, 3);
+            lua_pushvalue(L, 3);
+            system->function = luaL_ref(L, LUA_REGISTRYINDEX);
+            for (size_t i = 0; i < size; i++) {
+                PushFloatView(L, nullptr, 0);
+                system->views.push_back(luaL_ref(L, LUA_REGISTRYINDEX));
+            }
+            return 0;
+        }
+
+        static int l_removeSystem(lua_State* L) {
+            ScriptSystems* self = Self(L);
+            System* system = self->Find(luaL_checkstring(L, 1));
+            if (system) Release(L, *system);
+            lua_pushboolean(L, system != nullptr);
+            return 1;
+        }
+
+    public:
+        ScriptSystems() = default;
+        ScriptSystems(const ScriptSystems&) = delete;
+        ScriptSystems& operator=(const ScriptSystems&) = delete;
+
+        void Register(lua_State* L) {
+            lua_pushlightuserdata(L, this);
+            lua_pushcclosure(L, l_registerSystem, 1);
+            lua_setglobal(L, "registerSystem");
+            lua_pushlightuserdata(L, this);
+            lua_pushcclosure(L, l_removeSystem, 1);
+            lua_setglobal(L, "removeSystem");
+        }
+
+        size_t Count() const { return systems.size(); }
+        const System& Get(size_t index) const { return systems[index]; }
+
+        // Drops removed systems; indices change, so only between runs
+        void Compact() {
+            systems.erase(std::remove_if(systems.begin(), systems.end(), [](const System& system) { return system.removed; }), systems.end());
+        }
+
+        void Remove(lua_State* L, size_t index) {
+            if (!systems[index].removed) Release(L, systems[index]);
+        }
+
+        // Removes the systems whose function a script instance (its environment table) defined
+        void StopOwner(lua_State* L, const void* owner) {
+            for (auto& system : systems) {
+                if (!system.removed && system.owner == owner) Release(L, system);
+            }
+        }
+
+        // Pushes the function and its arguments: dt, count and one view per query entry over
+        // data[k], which holds count objects' floats. Returns the number of arguments.
+        int Push(lua_State* L, size_t index, float dt, size_t count, float* const* data, const size_t* floats) {
+            System& system = systems[index];
+            lua_rawgeti(L, LUA_REGISTRYINDEX, system.function);
+            lua_pushnumber(L, dt);
+            lua_pushinteger(L, (lua_Integer)count);
+            for (size_t k = 0; k < system.views.size(); k++) {
+                lua_rawgeti(L, LUA_REGISTRYINDEX, system.views[k]);
+                auto* view = static_cast<FloatArray*>(lua_touserdata(L, -1));
+                view->data = data[k];
+                view->count = count * floats[k];
+            }
+            return 2 + (int)system.views.size();
+        }
+
+        // After the call: the buffers belong to the scene
+        void ClearViews(lua_State* L, size_t index) {
+            for (int ref : systems[index].views) {
+                lua_rawgeti(L, LUA_REGISTRYINDEX, ref);
+                ClearFloatView(static_cast<FloatArray*>(lua_touserdata(L, -1)));
+                lua_pop(L, 1);
+            }
+        }
+    };
+}
+
+#endif
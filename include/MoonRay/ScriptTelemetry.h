@@ -0,0 +1,103 @@
+/*
+ * Copyright (C) 2026 Artem Svitlov (Moscow, Russia)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// Per-VM Lua telemetry for the debug UI. Every ScriptVM publishes a sample once per frame from
+// its own thread (only while someone is looking, see Enable), the UI takes a snapshot from the
+// render thread.
+
+#ifndef MOONRAY_SCRIPT_TELEMETRY_H
+#define MOONRAY_SCRIPT_TELEMETRY_H
+
+#include <mutex>
+#include <atomic>
+#include <map>
+#include <vector>
+#include <cstdint>
+#include <cstddef>
+
+namespace MoonRay {
+    struct ScriptGCStats {
+        size_t heapKB = 0;
+        size_t peakKB = 0;
+        size_t reservedKB = 0;          // Allocator pool chunks
+        size_t limitKB = 0;             // 0 = unlimited
+        uint64_t failedAllocations = 0; // Refused by the memory limit
+        uint64_t budgetOverruns = 0;    // Calls stopped by the instruction budget or time limit
+        int budgetUs = 0;               // 0 = Lua's automatic collector
+        float lastStepUs = 0.0f;        // GC time spent in the last frame
+        float avgStepUs = 0.0f;         // Moving average
+        float maxStepUs = 0.0f;
+        uint64_t cycles = 0;            // Completed collection cycles (engine-driven mode)
+        int boost = 1;                  // Budget multiplier while the collector lags behind
+    };
+
+    class ScriptTelemetry {
+    public:
+        static constexpr size_t HistorySize = 120;
+
+        struct Entry {
+            uint64_t vm = 0;
+            ScriptGCStats gc;
+            std::vector<float> heapHistory;     // KB, oldest first
+            std::vector<float> stepHistory;     // Microseconds
+        };
+
+    private:
+        std::mutex mutex;
+        std::map<uint64_t, Entry> entries;
+        std::atomic<bool> enabled{ false };
+
+        static void PushSample(std::vector<float>& history, float value) {
+            if (history.size() >= HistorySize) history.erase(history.begin());
+            history.push_back(value);
+        }
+
+    public:
+        static ScriptTelemetry& Get() {
+            static ScriptTelemetry telemetry;
+            return telemetry;
+        }
+
+        // Publishing costs a lock and a copy per VM and frame, so it is off until the UI asks for it
+        void Enable(bool value) { enabled.store(value, std::memory_order_relaxed); }
+        bool Enabled() const { return enabled.load(std::memory_order_relaxed); }
+
+        void Publish(uint64_t vm, const ScriptGCStats& gc) {
+            std::lock_guard<std::mutex> lock(mutex);
+            Entry& entry = entries[vm];
+            entry.vm = vm;
+            entry.gc = gc;
+            PushSample(entry.heapHistory, (float)gc.heapKB);
+            PushSample(entry.stepHistory, gc.lastStepUs);
+        }
+
+        void Remove(uint64_t vm) {
+            std::lock_guard<std::mutex> lock(mutex);
+            entries.erase(vm);
+        }
+
+        std::vector<Entry> Snapshot() {
+            std::lock_guard<std::mutex> lock(mutex);
+            std::vector<Entry> result;
+            result.reserve(entries.size());
+            for (const auto& entry : entries) result.push_back(entry.second);
+            return result;
+        }
+    };
+}
+
+#endif
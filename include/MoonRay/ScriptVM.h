@@ -0,0 +1,600 @@
+/*
+ * Copyright (C) 2026 Artem Svitlov (Moscow, Russia)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// One Lua VM shared by every script of a scene. The API is registered once per VM, each script
+// file is compiled once, and every script instance runs that chunk with its own environment
+// table (globals it defines stay private, reads fall back to _G).
+
+#ifndef MOONRAY_SCRIPT_VM_H
+#define MOONRAY_SCRIPT_VM_H
+
+#include "lua.hpp"
+#include "MoonRay/MoonRayLua.h"
+#include "MoonRay/BytecodeCache.h"
+#include "MoonRay/ScriptWatcher.h"
+#include "MoonRay/ScriptTelemetry.h"
+#include "MoonRay/LuaAllocator.h"
+#include "MoonRay/ScriptProfiler.h"
+#include "MoonRay/ScriptScheduler.h"
+#include "MoonRay/ScriptSystems.h"
+#include "MoonRay/ScriptMessages.h"
+#include "MoonRay/ScriptWatchdog.h"
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <functional>
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <iostream>
+
+namespace MoonRay {
+    class ScriptVM {
+    private:
+        LuaPoolAllocator allocator;                     // Declared before L: outlives lua_close()
+        size_t memoryLimit = DefaultMemoryLimit();
+        lua_State* L = nullptr;
+        std::unordered_map<std::string, int> chunks;    // Path -> compiled main chunk (registry ref)
+        int envMeta = LUA_NOREF;                        // { __index = _G }, shared by all environments
+        int binder = LUA_NOREF;                         // Returns a closure whose only upvalue is its argument
+
+        struct Instance {
+            std::string path;
+            std::function<void()> reloaded;
+        };
+        std::unordered_map<int, Instance> instances;    // Environment ref -> script instance
+        uint64_t reloadGeneration = 0;                  // Last ScriptWatcher generation applied
+        ScriptScheduler scheduler;
+        ScriptSystems systems;
+        std::vector<ScriptMessage> outbox;              // broadcast() calls since the last TakeMessages()
+
+        const uint64_t id = NextId()++;                 // Telemetry key
+        int gcBudgetUs = DefaultGCBudget();
+        bool gcManual = false;                          // Collector stopped, driven by StepGC()
+        bool gcInCycle = false;
+        size_t gcPauseKB = 0;                           // Next cycle starts once the heap reaches this
+        size_t gcLastHeapKB = 0;                        // Heap after the previous StepGC()
+        size_t gcDebtKB = 0;                            // Allocation the collector hasn't paid for yet
+        static constexpr size_t GCSliceKB = 16;         // Work per lua_gc call, between clock checks
+        ScriptGCStats gcStats;
+
+        using Clock = std::chrono::steady_clock;
+        int callDepth = 0;                              // Nested EnterScript()s, script time is measured at depth 0
+        uint64_t profilerGeneration = 0;                // Last ScriptProfiler generation applied
+        bool profiling = false;
+        Clock::time_point profileMark;                  // Start of the current top-level call
+        double profilePendingUs = 0.0;                  // Script time not charged to a sample yet
+
+        int64_t instructionBudget = DefaultInstructionBudget();
+        int timeLimitUs = DefaultTimeLimit();
+        int64_t budgetUsed = 0;                         // Instructions since the call started (in hook steps)
+        bool overran = false;                           // The last top-level call hit the budget
+        uint64_t overruns = 0;
+        ScriptWatchdog::Slot watchdog{ Hook };
+        static constexpr int BudgetCheckInstructions = 10000;
+
+        static std::atomic<uint64_t>& NextId() {
+            static std::atomic<uint64_t> next{ 1 };
+            return next;
+        }
+
+        size_t HeapKB() const { return (size_t)lua_gc(L, LUA_GCCOUNT, 0); }
+
+        // What luaL_newstate installs, for errors outside any pcall
+        static int Panic(lua_State* state) {
+            const char* message = lua_tostring(state, -1);
+            std::cerr << "LUA PANIC: unprotected error in call to Lua API (" << (message ? message : "(non-string error)") << ")" << std::endl;
+            return 0;
+        }
+
+        // The one hook of the state (and of coroutines created after it was set, which copy it).
+        // Every feature that needs a hook is dispatched from here; UpdateHook() sets the mask.
+        // The watchdog may also install it with a count of 1 on the running thread.
+        static void Hook(lua_State* state, lua_Debug* ar) {
+            ScriptVM* vm = *static_cast<ScriptVM**>(lua_getextraspace(state));
+            if (ar->event != LUA_HOOKCOUNT) return;
+            if (lua_gethookcount(state) == 1) vm->CheckTimeLimit(state);
+            if (vm->callDepth == 0) return;
+            if (vm->profiling) vm->ProfileTick(state);
+            if (vm->instructionBudget > 0) vm->CheckInstructionBudget(state);
+        }
+
+        // Coroutines keep the hook they were created with until it is set on them again
+        void UpdateHook(lua_State* thread = nullptr) {
+            int count = 0;
+            if (profiling) count = ScriptProfiler::HookInstructions;
+            else if (instructionBudget > 0) count = BudgetCheckInstructions;
+            lua_sethook(thread ? thread : L, count ? Hook : nullptr, count ? LUA_MASKCOUNT : 0, count);
+        }
+
+        // Raises "file:line: script exceeded its <format>" in the running script
+        void Overrun(lua_State* state, const char* format, int limit) {
+            if (!overran) overruns++;
+            overran = true;
+            luaL_where(state, 0);       // Level 0 inside a hook is the running function
+            lua_pushliteral(state, "script exceeded its ");
+            lua_pushfstring(state, format, limit);
+            lua_concat(state, 3);
+            lua_error(state);
+        }
+
+        // Reached through the watchdog's hook: errors while the call is over time, otherwise (the
+        // call ended before the hook was set) puts the normal hook back
+        void CheckTimeLimit(lua_State* state) {
+            if (callDepth > 0 && watchdog.Expired()) Overrun(state, "time limit of %d ms", timeLimitUs / 1000);
+            UpdateHook(state);
+        }
+
+        void CheckInstructionBudget(lua_State* state) {
+            budgetUsed += lua_gethookcount(state);
+            if (budgetUsed > instructionBudget) Overrun(state, "budget of %d instructions", (int)std::min<int64_t>(instructionBudget, INT32_MAX));
+        }
+
+        // Every top-level call and every coroutine resumed by the scheduler starts a new budget
+        void ResetBudget() {
+            overran = false;
+            budgetUsed = 0;
+            if (timeLimitUs > 0) watchdog.Arm(L, Clock::now() + std::chrono::microseconds(timeLimitUs));
+        }
+
+        void SyncProfiler() {
+            ScriptProfiler& profiler = ScriptProfiler::Get();
+            profilerGeneration = profiler.Generation();
+            profiling = profiler.Running();
+            profilePendingUs = 0.0;
+            UpdateHook();
+        }
+
+        void ProfileTick(lua_State* state) {
+            auto now = Clock::now();
+            double elapsed = profilePendingUs + std::chrono::duration<double, std::micro>(now - profileMark).count();
+            if (elapsed < ScriptProfiler::Get().Interval()) return;
+            ScriptProfiler::Get().Sample(state, elapsed);
+            profilePendingUs = 0.0;
+            profileMark = Clock::now();     // The sample itself isn't script time
+        }
+
+        // Brackets everything that runs script code: the memory limit is enforced inside, and the
+        // profiler only counts time inside
+        void EnterScript() {
+            if (callDepth++ > 0) return;
+            if (profilerGeneration != ScriptProfiler::Get().Generation()) SyncProfiler();
+            ResetBudget();
+            if (profiling) profileMark = Clock::now();
+            allocator.SetEnforcing(true);
+        }
+
+        void LeaveScript() {
+            if (--callDepth > 0) return;
+            watchdog.Disarm();
+            allocator.SetEnforcing(false);
+            if (profiling) profilePendingUs += std::chrono::duration<double, std::micro>(Clock::now() - profileMark).count();
+        }
+
+        // broadcast(name, ...): queued, the owner hands it to every VM of the scene (Deliver)
+        static int l_broadcast(lua_State* state) {
+            ScriptVM* vm = static_cast<ScriptVM*>(lua_touserdata(state, lua_upvalueindex(1)));
+            ScriptMessage message;
+            message.name = luaL_checkstring(state, 1);
+            message.count = lua_gettop(state) - 1;
+            for (int i = 2; i <= message.count + 1; i++) Messages::Encode(state, i, message.data);
+            vm->outbox.push_back(std::move(message));
+            return 0;
+        }
+
+        // Prints and pops the error message on top of the stack
+        void Report() {
+            const char* message = lua_tostring(L, -1);
+            std::cerr << "LUA ERROR: " << (message ? message : "(non-string error)") << std::endl;
+            lua_pop(L, 1);
+        }
+
+        // Compiled once per path (through the bytecode cache); LUA_NOREF if the file failed to
+        // compile (reported once)
+        int Compile(const std::string& path) {
+            auto it = chunks.find(path);
+            if (it != chunks.end()) return it->second;
+
+            ScriptWatcher::Get().Watch(path);
+            int ref = LUA_NOREF;
+            if (BytecodeCache::LoadScript(L, path) == LUA_OK) {
+                ref = luaL_ref(L, LUA_REGISTRYINDEX);
+            } else {
+                Report();
+            }
+            chunks[path] = ref;
+            return ref;
+        }
+
+        // Binds the chunk on top of the stack to the environment at envIndex through a fresh
+        // holder closure and leaves [holder, chunk] on the stack.
+        void BindChunk(int envIndex) {
+            lua_rawgeti(L, LUA_REGISTRYINDEX, binder);
+            lua_pushvalue(L, envIndex);
+            lua_call(L, 1, 1);
+            lua_insert(L, -2);
+            lua_upvaluejoin(L, -1, 1, -2, 1);
+        }
+
+        // Runs the new version of the script for an existing instance. The chunk runs in a scratch
+        // environment that reads through to the live one, so `state = state or {}` sees the old
+        // state. Functions it defines replace the old ones and new globals are added, values the
+        // instance already has are kept. The new closures are then pointed at the live environment.
+        void Reinstantiate(int chunk, int env, const Instance& instance) {
+            lua_rawgeti(L, LUA_REGISTRYINDEX, env);
+            int live = lua_gettop(L);
+
+            lua_newtable(L);
+            lua_createtable(L, 0, 1);
+            lua_pushvalue(L, live);
+            lua_setfield(L, -2, "__index");
+            lua_setmetatable(L, -2);
+            int scratch = lua_gettop(L);
+
+            lua_rawgeti(L, LUA_REGISTRYINDEX, chunk);
+            BindChunk(scratch);
+            int holder = scratch + 1;
+            bool ok = Call(0, 0);
+
+            if (ok) {
+                lua_pushnil(L);
+                while (lua_next(L, scratch)) {
+                    lua_pushvalue(L, -2);
+                    bool keep = lua_rawget(L, live) != LUA_TNIL && !lua_isfunction(L, -2);
+                    lua_pop(L, 1);
+                    if (keep) {
+                        lua_pop(L, 1);
+                        continue;
+                    }
+                    lua_pushvalue(L, -2);
+                    lua_insert(L, -2);
+                    lua_rawset(L, live);
+                }
+            }
+
+            // Every closure the chunk created shares the holder's _ENV upvalue
+            lua_pushvalue(L, live);
+            lua_setupvalue(L, holder, 1);
+
+            if (ok && lua_getfield(L, live, "OnReload") == LUA_TFUNCTION) Call(0, 0);
+            lua_settop(L, live - 1);
+
+            if (ok && instance.reloaded) instance.reloaded();
+        }
+
+        void Reload(const ScriptWatcher::Change& change) {
+            for (auto& chunk : chunks) {
+                if (chunk.second == LUA_NOREF || BytecodeCache::NormalizePath(chunk.first) != change.path) continue;
+
+                std::string name = "@" + chunk.first;
+                if (luaL_loadbuffer(L, change.bytecode.data(), change.bytecode.size(), name.c_str()) != LUA_OK) {
+                    Report();
+                    continue;
+                }
+                luaL_unref(L, LUA_REGISTRYINDEX, chunk.second);
+                chunk.second = luaL_ref(L, LUA_REGISTRYINDEX);
+
+                // Collected first: OnReload or the reloaded callback may release instances
+                std::vector<int> envs;
+                for (const auto& instance : instances) {
+                    if (instance.second.path == chunk.first) envs.push_back(instance.first);
+                }
+                for (int env : envs) {
+                    auto it = instances.find(env);
+                    if (it != instances.end()) Reinstantiate(chunk.second, env, Instance(it->second));
+                }
+            }
+        }
+
+    public:
+        ScriptVM() = default;
+
+        ~ScriptVM() {
+            if (!L) return;
+            ScriptTelemetry::Get().Remove(id);
+            ScriptWatchdog::Get().Remove(&watchdog);
+            lua_close(L);
+        }
+
+        ScriptVM(const ScriptVM&) = delete;
+        ScriptVM& operator=(const ScriptVM&) = delete;
+
+        // Created on first use, so scenes without scripts don't pay for a VM
+        lua_State* State() {
+            if (L) return L;
+
+            L = lua_newstate(LuaPoolAllocator::Alloc, &allocator);
+            *static_cast<ScriptVM**>(lua_getextraspace(L)) = this;
+            lua_atpanic(L, Panic);
+            luaL_openlibs(L);
+            RegisterAPI(L);
+            scheduler.Register(L);
+            systems.Register(L);
+            lua_pushlightuserdata(L, this);
+            lua_pushcclosure(L, l_broadcast, 1);
+            lua_setglobal(L, "broadcast");
+            scheduler.SetWatchdog(&watchdog);
+            ScriptWatchdog::Get().Add(&watchdog);
+            UpdateHook();
+
+            lua_createtable(L, 0, 1);
+            lua_pushglobaltable(L);
+            lua_setfield(L, -2, "__index");
+            envMeta = luaL_ref(L, LUA_REGISTRYINDEX);
+
+            luaL_loadstring(L, "local env = ... return function() return env end");
+            binder = luaL_ref(L, LUA_REGISTRYINDEX);
+
+            allocator.SetLimit(memoryLimit);
+            return L;
+        }
+
+        // Runs the script in a fresh environment table and returns its registry ref
+        // (LUA_NOREF on error). The table holds the instance's globals: OnUpdate, OnRender, state.
+        // `reloaded` runs after a hot reload replaced the instance's functions (see ApplyReloads).
+        // `setup` runs with the new environment on top of the stack, before the main chunk.
+        int Instantiate(const std::string& path, std::function<void()> reloaded = nullptr,
+                        const std::function<void(lua_State*)>& setup = nullptr) {
+            State();
+            int chunk = Compile(path);
+            if (chunk == LUA_NOREF) return LUA_NOREF;
+
+            lua_newtable(L);
+            lua_rawgeti(L, LUA_REGISTRYINDEX, envMeta);
+            lua_setmetatable(L, -2);
+            if (setup) setup(L);
+
+            // The main chunk's only upvalue is _ENV. Joining it to a new upvalue that holds this
+            // environment gives the instance its own _ENV; closures made by earlier instances keep
+            // the upvalue they captured.
+            lua_rawgeti(L, LUA_REGISTRYINDEX, chunk);
+            BindChunk(lua_gettop(L) - 1);
+            lua_remove(L, -2);
+
+            if (!Call(0, 0)) {
+                lua_pop(L, 1);
+                return LUA_NOREF;
+            }
+            int env = luaL_ref(L, LUA_REGISTRYINDEX);
+            instances[env] = { path, std::move(reloaded) };
+            return env;
+        }
+
+        void Release(int ref) {
+            if (!L || ref == LUA_NOREF || ref == LUA_REFNIL) return;
+            if (instances.erase(ref) && (!scheduler.Empty() || systems.Count() > 0)) {
+                lua_rawgeti(L, LUA_REGISTRYINDEX, ref);
+                scheduler.StopOwner(L, lua_topointer(L, -1));
+                systems.StopOwner(L, lua_topointer(L, -1));
+                lua_pop(L, 1);
+            }
+            luaL_unref(L, LUA_REGISTRYINDEX, ref);
+        }
+
+        // Swaps in scripts the ScriptWatcher recompiled since the last call. Called by the owner
+        // at a frame boundary (Scene::Update); a single atomic load when nothing changed.
+        void ApplyReloads() {
+            if (!L) return;
+            ScriptWatcher& watcher = ScriptWatcher::Get();
+            if (watcher.Generation() == reloadGeneration) return;
+
+            std::vector<ScriptWatcher::Change> changes;
+            reloadGeneration = watcher.ChangesSince(reloadGeneration, changes);
+            for (const auto& change : changes) Reload(change);
+        }
+
+        // Advances the coroutine scheduler by one frame and resumes the coroutines that are due.
+        // Called by the owner once per frame before the scripts' OnUpdate (Scene::Update).
+        void RunCoroutines(float dt) {
+            if (!L || scheduler.Empty()) return;
+            EnterScript();
+            scheduler.Tick(L, dt, [this] { ResetBudget(); });     // Every coroutine gets a full budget
+            LeaveScript();
+        }
+
+        size_t CoroutineCount() const { return scheduler.Count(); }
+
+        // Lua systems, run by the scene (Scene::RunSystems). Compact between runs only.
+        size_t SystemCount() const { return systems.Count(); }
+        const ScriptSystems::System& System(size_t index) const { return systems.Get(index); }
+        void CompactSystems() { systems.Compact(); }
+
+        // Calls system `index` on one batch: data[k] holds count objects' floats[k] floats of
+        // query entry k. A system that goes over its budget is removed. Returns false on error.
+        bool RunSystem(size_t index, float dt, size_t count, float* const* data, const size_t* floats) {
+            if (!L || systems.Get(index).removed) return false;
+            int nargs = systems.Push(L, index, dt, count, data, floats);
+            bool ok = Call(nargs, 0);
+            systems.ClearViews(L, index);
+            if (overran) {
+                std::cerr << "LUA: system " << systems.Get(index).name << " removed after going over its budget" << std::endl;
+                systems.Remove(L, index);
+            }
+            return ok;
+        }
+
+        // Moves the messages broadcast since the last call to the end of out
+        void TakeMessages(std::vector<ScriptMessage>& out) {
+            for (auto& message : outbox) out.push_back(std::move(message));
+            outbox.clear();
+        }
+
+        // Wakes waitUntil(name) coroutines and calls OnMessage(name, ...) of every instance that
+        // defines it, for each message in order
+        void Deliver(const std::vector<ScriptMessage>& messages) {
+            if (!L || messages.empty()) return;
+            std::vector<int> envs;
+            envs.reserve(instances.size());
+            for (const auto& instance : instances) envs.push_back(instance.first);
+            std::sort(envs.begin(), envs.end());
+
+            for (const auto& message : messages) {
+                int top = lua_gettop(L);
+                lua_pushstring(L, message.name.c_str());
+                int nargs = Messages::Push(L, message);
+
+                if (!scheduler.Empty()) {
+                    EnterScript();
+                    scheduler.Signal(L, message.name, top + 2, nargs);
+                    LeaveScript();
+                }
+                for (int env : envs) {
+                    if (!instances.count(env)) continue;
+                    lua_rawgeti(L, LUA_REGISTRYINDEX, env);
+                    if (lua_getfield(L, -1, "OnMessage") != LUA_TFUNCTION) {
+                        lua_pop(L, 2);
+                        continue;
+                    }
+                    lua_remove(L, -2);
+                    for (int i = top + 1; i <= top + 1 + nargs; i++) lua_pushvalue(L, i);
+                    Call(nargs + 1, 0);
+                }
+                lua_settop(L, top);
+            }
+        }
+
+        // Limits on a single call into a script (callback, main chunk or coroutine resume) for
+        // VMs created from now on: VM instructions, and wall time in microseconds; 0 = none.
+        // A script over either gets an error, LuaScriptComponent then suspends it. The time limit
+        // costs nothing per instruction (ScriptWatchdog) but also counts time spent waiting in
+        // engine calls (LoadTexture waits for the render thread), so both are off unless asked
+        // for. An instruction budget keeps a count hook set, which makes Lua 5.3 scripts about
+        // 15% slower.
+        static int64_t& DefaultInstructionBudget() {
+            static int64_t budget = 0;
+            return budget;
+        }
+
+        static int& DefaultTimeLimit() {
+            static int limit = 0;
+            return limit;
+        }
+
+        void SetInstructionBudget(int64_t instructions) {
+            instructionBudget = instructions;
+            if (L) UpdateHook();
+        }
+
+        void SetTimeLimit(int microseconds) {
+            timeLimitUs = microseconds;
+            if (L) UpdateHook();
+        }
+
+        // Whether the last top-level Call() was stopped by the budget
+        bool Overran() const { return overran; }
+        uint64_t BudgetOverruns() const { return overruns; }
+
+        // Per-frame GC budget for VMs created from now on, in microseconds. 0 leaves collection
+        // to Lua's automatic collector, which may then run a long step in the middle of OnUpdate.
+        static int& DefaultGCBudget() {
+            static int budget = 500;
+            return budget;
+        }
+
+        void SetGCBudget(int microseconds) {
+            gcBudgetUs = microseconds;
+            if (L && gcBudgetUs <= 0 && gcManual) {
+                lua_gc(L, LUA_GCRESTART, 0);
+                gcManual = false;
+            }
+        }
+
+        const ScriptGCStats& GCStats() const { return gcStats; }
+
+        // Hard cap on the VM's Lua heap in bytes for VMs created from now on, 0 = unlimited.
+        // Script code that would go over it gets a "not enough memory" error; the engine's own
+        // calls (instantiating, releasing refs) are never refused.
+        static size_t& DefaultMemoryLimit() {
+            static size_t limit = 0;
+            return limit;
+        }
+
+        void SetMemoryLimit(size_t bytes) {
+            memoryLimit = bytes;
+            if (L) allocator.SetLimit(bytes);
+        }
+
+        const LuaPoolAllocator::Stats& MemoryStats() const { return allocator.GetStats(); }
+
+        // Runs the collector between frames instead of inside OnUpdate; call once per frame in
+        // idle time (after the frame was recorded). The first call stops Lua's own collector, from
+        // then on memory is only reclaimed here. Pacing follows Lua's: every KB allocated since
+        // the last call owes a GC step, a new cycle starts once the heap has doubled since the
+        // last one. The budget caps the time spent per call. Work left over is carried to the
+        // next frame, with the budget doubled (up to 4x) until the collector has caught up.
+        void StepGC() {
+            if (!L) return;
+            float us = 0.0f;
+
+            if (gcBudgetUs > 0) {
+                if (!gcManual) {
+                    lua_gc(L, LUA_GCSTOP, 0);
+                    gcManual = true;
+                    gcLastHeapKB = HeapKB();
+                }
+
+                size_t heap = HeapKB();
+                if (!gcInCycle && heap >= gcPauseKB) gcInCycle = true;
+                if (gcInCycle) gcDebtKB += heap > gcLastHeapKB ? heap - gcLastHeapKB : 0;
+
+                if (gcInCycle && gcDebtKB > 0) {
+                    auto start = Clock::now();
+                    auto deadline = start + std::chrono::microseconds(gcBudgetUs * gcStats.boost);
+                    do {
+                        size_t slice = std::min<size_t>(gcDebtKB, GCSliceKB);
+                        gcDebtKB -= slice;
+                        if (lua_gc(L, LUA_GCSTEP, (int)slice) != 0) {
+                            gcInCycle = false;
+                            gcDebtKB = 0;
+                            gcPauseKB = std::max<size_t>(HeapKB() * 2, 256);
+                            gcStats.cycles++;
+                            break;
+                        }
+                    } while (gcDebtKB > 0 && Clock::now() < deadline);
+                    us = std::chrono::duration<float, std::micro>(Clock::now() - start).count();
+                    gcStats.boost = gcDebtKB > 0 ? std::min(gcStats.boost * 2, 4) : 1;
+                }
+                gcLastHeapKB = HeapKB();
+            }
+
+            const LuaPoolAllocator::Stats& memory = allocator.GetStats();
+            gcStats.heapKB = HeapKB();
+            gcStats.peakKB = memory.peak / 1024;
+            gcStats.reservedKB = memory.reserved / 1024;
+            gcStats.limitKB = memory.limit / 1024;
+            gcStats.failedAllocations = memory.failed;
+            gcStats.budgetOverruns = overruns;
+            gcStats.budgetUs = gcBudgetUs;
+            gcStats.lastStepUs = us;
+            gcStats.avgStepUs += (us - gcStats.avgStepUs) * 0.05f;
+            gcStats.maxStepUs = std::max(gcStats.maxStepUs, us);
+            if (ScriptTelemetry::Get().Enabled()) ScriptTelemetry::Get().Publish(id, gcStats);
+        }
+
+        // Protected call of the function below nargs arguments; errors are reported and popped
+        bool Call(int nargs, int nresults) {
+            EnterScript();
+            int status = lua_pcall(L, nargs, nresults, 0);
+            LeaveScript();
+            if (status == LUA_OK) return true;
+            Report();
+            return false;
+        }
+    };
+}
+
+#endif
@@ -0,0 +1,131 @@
+/*
+ * Copyright (C) 2026 Artem Svitlov (Moscow, Russia)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// Time limit for script calls without a hook on the hot path. Each ScriptVM arms its Slot with a
+// deadline when a call starts and disarms it when the call returns. Arming, and every coroutine
+// resume (Switch), takes the slot's mutex: uncontended unless the watchdog is installing a hook,
+// which keeps the Lua thread it hooks from being switched or freed meanwhile. Disarming is one
+// atomic store. One background thread looks at the armed slots every few milliseconds; when a
+// call is past its deadline it installs the slot's hook with a count of 1 on the Lua thread that
+// is running, and the hook raises the error on the next VM instruction. lua_sethook is the one
+// Lua API call meant to be made asynchronously (lua.c calls it from its SIGINT handler).
+
+#ifndef MOONRAY_SCRIPT_WATCHDOG_H
+#define MOONRAY_SCRIPT_WATCHDOG_H
+
+#include "lua.hpp"
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <vector>
+#include <algorithm>
+#include <cstdint>
+
+namespace MoonRay {
+    class ScriptWatchdog {
+    public:
+        using Clock = std::chrono::steady_clock;
+        static constexpr int PollMs = 5;
+
+        class Slot {
+        private:
+            friend class ScriptWatchdog;
+            std::atomic<int64_t> deadline{ 0 };     // Clock ticks, 0 = no call running
+            std::mutex mutex;                       // Guards running against the watchdog's lua_sethook
+            lua_State* running = nullptr;
+            lua_Hook hook = nullptr;
+            int64_t fired = 0;                      // Deadline the hook was installed for (watchdog thread only)
+
+        public:
+            explicit Slot(lua_Hook onExpired) : hook(onExpired) {}
+
+            void Arm(lua_State* thread, Clock::time_point until) {
+                Switch(thread);
+                deadline.store(until.time_since_epoch().count(), std::memory_order_release);
+            }
+
+            void Disarm() { deadline.store(0, std::memory_order_release); }
+
+            bool Expired() const {
+                int64_t until = deadline.load(std::memory_order_acquire);
+                return until != 0 && Clock::now().time_since_epoch().count() > until;
+            }
+
+            // Sets the Lua thread that is executing (coroutine resumes), returns the previous one
+            lua_State* Switch(lua_State* thread) {
+                std::lock_guard<std::mutex> lock(mutex);
+                lua_State* previous = running;
+                running = thread;
+                return previous;
+            }
+        };
+
+    private:
+        std::mutex mutex;
+        std::condition_variable wake;
+        std::vector<Slot*> slots;
+        std::thread thread;
+        bool stopping = false;
+
+        void Main() {
+            std::unique_lock<std::mutex> lock(mutex);
+            while (!stopping) {
+                wake.wait_for(lock, std::chrono::milliseconds(PollMs));
+                int64_t now = Clock::now().time_since_epoch().count();
+                for (Slot* slot : slots) {
+                    int64_t until = slot->deadline.load(std::memory_order_acquire);
+                    if (until == 0 || now <= until || slot->fired == until) continue;
+                    slot->fired = until;
+                    std::lock_guard<std::mutex> running(slot->mutex);
+                    if (slot->running) lua_sethook(slot->running, slot->hook, LUA_MASKCOUNT, 1);
+                }
+            }
+        }
+
+    public:
+        static ScriptWatchdog& Get() {
+            static ScriptWatchdog watchdog;
+            return watchdog;
+        }
+
+        ~ScriptWatchdog() {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                stopping = true;
+            }
+            wake.notify_all();
+            if (thread.joinable()) thread.join();
+        }
+
+        // The thread starts with the first slot
+        void Add(Slot* slot) {
+            std::lock_guard<std::mutex> lock(mutex);
+            slots.push_back(slot);
+            if (!thread.joinable()) thread = std::thread([this] { Main(); });
+        }
+
+        // After this returns the watchdog no longer touches the slot or its Lua state
+        void Remove(Slot* slot) {
+            std::lock_guard<std::mutex> lock(mutex);
+            slots.erase(std::remove(slots.begin(), slots.end(), slot), slots.end());
+        }
+    };
+}
+
+#endif
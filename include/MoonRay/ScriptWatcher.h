@@ -0,0 +1,290 @@
+/*
+ * Copyright (C) 2026 Artem Svitlov (Moscow, Russia)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// Script hot reload. Once started, the watcher thread sleeps on inotify (Linux) until a script
+// that some ScriptVM has loaded is written, recompiles it on its own private Lua state and
+// publishes the bytecode. Each ScriptVM picks the change up in ApplyReloads() at the start of
+// its next scene update, on the thread that owns it. Other platforms poll the file times
+// instead (a few stat calls every PollInterval on the watcher thread).
+
+#ifndef MOONRAY_SCRIPT_WATCHER_H
+#define MOONRAY_SCRIPT_WATCHER_H
+
+#include "lua.hpp"
+#include "MoonRay/BytecodeCache.h"
+#include <string>
+#include <vector>
+#include <unordered_map>
+#include <unordered_set>
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <chrono>
+#include <filesystem>
+#include <iostream>
+#include <cstdint>
+
+#ifdef __linux__
+#include <sys/inotify.h>
+#include <poll.h>
+#include <unistd.h>
+#include <cerrno>
+#endif
+
+namespace MoonRay {
+    class ScriptWatcher {
+    public:
+        struct Change {
+            std::string path;           // Normalized, see BytecodeCache::NormalizePath
+            std::string bytecode;
+        };
+
+    private:
+        struct Script {
+            std::string path;
+            uint64_t hash = 0;          // Source hash of the last compiled version
+            int64_t time = 0;           // Last write time seen (polling)
+            uint64_t generation = 0;    // Generation of the last recompile, 0 = never changed
+            std::string bytecode;
+        };
+
+        std::mutex mutex;
+        std::unordered_map<std::string, Script> scripts;
+        std::atomic<uint64_t> generation{ 0 };
+        std::atomic<bool> running{ false };
+        std::thread thread;
+        lua_State* compiler = nullptr;  // Watcher thread only
+
+#ifdef __linux__
+        int inotifyFd = -1;
+        int stopPipe[2] = { -1, -1 };
+        std::unordered_map<int, std::string> directories;  // Watch descriptor -> directory
+        std::unordered_set<std::string> watchedDirectories;
+#else
+        std::condition_variable wake;
+        bool stopping = false;
+#endif
+
+        ScriptWatcher() = default;
+
+        static int64_t WriteTime(const std::string& path) {
+            std::error_code ec;
+            auto time = std::filesystem::last_write_time(path, ec);
+            return ec ? 0 : (int64_t)time.time_since_epoch().count();
+        }
+
+        static bool SourceHash(const std::string& path, uint64_t& hash) {
+            std::vector<char> source;
+            if (!BytecodeCache::ReadFile(path, source)) return false;
+            hash = BytecodeCache::Hash(source.data(), source.size());
+            return true;
+        }
+
+        static int DumpWriter(lua_State*, const void* p, size_t size, void* ud) {
+            static_cast<std::string*>(ud)->append(static_cast<const char*>(p), size);
+            return 0;
+        }
+
+        // Watcher thread: compiles the changed script and publishes it. Saves that don't change
+        // the content (touch, editor autosave) and scripts that no longer compile are skipped.
+        void Recompile(const std::string& key) {
+            uint64_t hash;
+            if (!SourceHash(key, hash)) return;
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                auto it = scripts.find(key);
+                if (it == scripts.end() || it->second.hash == hash) return;
+            }
+
+            if (!compiler) compiler = luaL_newstate();
+            std::string bytecode;
+            if (BytecodeCache::LoadScript(compiler, key) != LUA_OK) {
+                const char* message = lua_tostring(compiler, -1);
+                std::cerr << "LUA ERROR: " << (message ? message : "(non-string error)") << " (not reloaded)" << std::endl;
+                lua_settop(compiler, 0);
+                return;
+            }
+            lua_dump(compiler, DumpWriter, &bytecode, 0);
+            lua_settop(compiler, 0);
+
+            std::lock_guard<std::mutex> lock(mutex);
+            Script& script = scripts[key];
+            script.hash = hash;
+            script.bytecode.swap(bytecode);
+            script.generation = ++generation;
+            std::cout << "[RELOAD] " << key << std::endl;
+        }
+
+#ifdef __linux__
+        // Directories are watched, not files: editors often save by renaming a new file over the old one
+        void AddDirectoryWatch(const std::string& key) {
+            std::string directory = std::filesystem::path(key).parent_path().string();
+            if (directory.empty()) directory = ".";
+            if (!watchedDirectories.insert(directory).second) return;
+
+            int wd = inotify_add_watch(inotifyFd, directory.c_str(), IN_CLOSE_WRITE | IN_MOVED_TO);
+            if (wd >= 0) directories[wd] = directory;
+        }
+
+        void Main() {
+            alignas(inotify_event) char buffer[16 * 1024];
+            pollfd fds[2] = { { inotifyFd, POLLIN, 0 }, { stopPipe[0], POLLIN, 0 } };
+
+            while (true) {
+                if (poll(fds, 2, -1) < 0) {
+                    if (errno == EINTR) continue;
+                    break;
+                }
+                if (fds[1].revents) break;
+
+                ssize_t length = read(inotifyFd, buffer, sizeof(buffer));
+                if (length <= 0) continue;
+
+                std::unordered_set<std::string> changed;
+                {
+                    std::lock_guard<std::mutex> lock(mutex);
+                    for (char* p = buffer; p < buffer + length; p += sizeof(inotify_event) + reinterpret_cast<inotify_event*>(p)->len) {
+                        auto* event = reinterpret_cast<inotify_event*>(p);
+                        auto dir = directories.find(event->wd);
+                        if (event->len == 0 || dir == directories.end()) continue;
+
+                        std::string key = BytecodeCache::NormalizePath(dir->second + "/" + event->name);
+                        if (scripts.count(key)) changed.insert(key);
+                    }
+                }
+                for (const auto& key : changed) Recompile(key);
+            }
+        }
+#else
+        void Main() {
+            std::unique_lock<std::mutex> lock(mutex);
+            while (!wake.wait_for(lock, PollInterval, [this] { return stopping; })) {
+                std::vector<std::string> changed;
+                for (auto& entry : scripts) {
+                    int64_t time = WriteTime(entry.first);
+                    if (time != 0 && time != entry.second.time) {
+                        entry.second.time = time;
+                        changed.push_back(entry.first);
+                    }
+                }
+                lock.unlock();
+                for (const auto& key : changed) Recompile(key);
+                lock.lock();
+            }
+        }
+#endif
+
+    public:
+        static constexpr std::chrono::milliseconds PollInterval{ 250 };
+
+        static ScriptWatcher& Get() {
+            static ScriptWatcher watcher;
+            return watcher;
+        }
+
+        ~ScriptWatcher() { Stop(); }
+
+        ScriptWatcher(const ScriptWatcher&) = delete;
+        ScriptWatcher& operator=(const ScriptWatcher&) = delete;
+
+        // Call before scenes load their scripts; only scripts loaded afterwards are watched
+        bool Start() {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (running) return true;
+#ifdef __linux__
+            inotifyFd = inotify_init1(IN_NONBLOCK | IN_CLOEXEC);
+            if (inotifyFd < 0) return false;
+            if (pipe(stopPipe) != 0) {
+                close(inotifyFd);
+                inotifyFd = -1;
+                return false;
+            }
+#else
+            stopping = false;
+#endif
+            running = true;
+            thread = std::thread([this] { Main(); });
+            return true;
+        }
+
+        void Stop() {
+            {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (!running) return;
+                running = false;
+#ifdef __linux__
+                char stop = 1;
+                ssize_t written = write(stopPipe[1], &stop, 1);
+                (void)written;
+#else
+                stopping = true;
+#endif
+            }
+#ifndef __linux__
+            wake.notify_all();
+#endif
+            thread.join();
+
+            std::lock_guard<std::mutex> lock(mutex);
+#ifdef __linux__
+            close(inotifyFd);
+            close(stopPipe[0]);
+            close(stopPipe[1]);
+            inotifyFd = stopPipe[0] = stopPipe[1] = -1;
+            directories.clear();
+            watchedDirectories.clear();
+#endif
+            scripts.clear();
+            if (compiler) lua_close(compiler);
+            compiler = nullptr;
+        }
+
+        bool Running() const { return running; }
+
+        // Called by ScriptVM for every script it compiles. No-op while the watcher is stopped.
+        void Watch(const std::string& path) {
+            if (!running) return;
+            std::string key = BytecodeCache::NormalizePath(path);
+
+            std::lock_guard<std::mutex> lock(mutex);
+            if (!running || scripts.count(key)) return;
+
+            Script& script = scripts[key];
+            script.path = key;
+            SourceHash(key, script.hash);
+            script.time = WriteTime(key);
+#ifdef __linux__
+            AddDirectoryWatch(key);
+#endif
+        }
+
+        // Bumped on every published recompile; one atomic load is all ApplyReloads() costs otherwise
+        uint64_t Generation() const { return generation.load(std::memory_order_acquire); }
+
+        // Scripts recompiled after generation `since`. Returns the generation the list is current to.
+        uint64_t ChangesSince(uint64_t since, std::vector<Change>& out) {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (const auto& entry : scripts) {
+                if (entry.second.generation > since) out.push_back({ entry.first, entry.second.bytecode });
+            }
+            return generation.load(std::memory_order_relaxed);
+        }
+    };
+}
+
+#endif
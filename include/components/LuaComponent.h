@@ -21,52 +21,170 @@
 #define LUA_COMPONENT_H
 
 #include "core/Component.h"
-#include "MoonRay/MoonRayLua.h"
+#include "core/GameObject.h"
+#include "core/Scene.h"
+#include "components/TransformComponent.h"
+#include "components/Transform2D.h"
+#include "MoonRay/ScriptVM.h"
+#include <memory>
+#include <string>
+#include <vector>
 #include <iostream>
 
+// Script instance running in its scene's shared VM. Binding is lazy (first Update/Draw), because
+// the component is usually created before its GameObject is added to a scene.
+//
+// The environment gets zero-copy FloatArray views of the owner's transforms: `transform`
+// (position xyz, rotation axis xyz, angle, scale xyz) and `transform2D` (position xy, rotation,
+// scale xy), when the GameObject has them.
+//
+// An isolated script gets a VM of its own instead. Once bound, its OnUpdate runs on the scene's
+// job system in parallel with other isolated scripts; it shares no Lua state with the rest of
+// the scene and talks to it through broadcast() messages.
 class LuaScriptComponent : public Component {
 private:
-    lua_State* L;
     std::string path;
+    bool isolated = false;
+    mutable MoonRay::ScriptVM* vm = nullptr;
+    mutable std::unique_ptr<MoonRay::ScriptVM> ownVM;  // Isolated, or used outside a scene
+    mutable Scene* isolatedScene = nullptr;             // Scene the own VM is registered with
+    mutable int env = LUA_NOREF;
+    mutable int onUpdate = LUA_NOREF;   // Callbacks resolved once after load (registry refs)
+    mutable int onRender = LUA_NOREF;
+    mutable bool suspended = false;     // Went over the VM's budget, skipped until reloaded
+    mutable std::vector<int> views;     // Registry refs of the FloatArray views, cleared on destruction
 
-public:
-    LuaScriptComponent(std::string scriptPath) : path(scriptPath) {
-        L = luaL_newstate();
-        luaL_openlibs(L);
-        MoonRay::RegisterAPI(L);
+    lua_State* Bind() const {
+        if (!vm) {
+            Scene* scene = owner ? owner->GetScene() : nullptr;
+            if (scene && !isolated) {
+                vm = &scene->GetScriptVM();
+            } else {
+                ownVM = std::make_unique<MoonRay::ScriptVM>();
+                vm = ownVM.get();
+                if (scene) scene->AddIsolatedVM(vm);
+                isolatedScene = scene;
+            }
+            env = vm->Instantiate(path, [this] { ResolveCallbacks(); }, [this](lua_State* L) { AddViews(L); });
+            ResolveCallbacks();
+        }
+        return env == LUA_NOREF ? nullptr : vm->State();
+    }
 
-        if (luaL_dofile(L, path.c_str()) != LUA_OK) {
-            std::cerr << "LUA ERROR: " << lua_tostring(L, -1) << std::endl;
+    // env is on top of the stack
+    void AddViews(lua_State* L) const {
+        if (!owner) return;
+        if (auto* transform = owner->GetComponent<TransformComponent>()) {
+            AddView(L, "transform", transform->Data(), TransformComponent::FloatCount);
+        }
+        if (auto* transform = owner->GetComponent<Transform2DComponent>()) {
+            AddView(L, "transform2D", transform->Data(), Transform2DComponent::FloatCount);
         }
     }
 
-    ~LuaScriptComponent() {
-        if (L) lua_close(L);
+    void AddView(lua_State* L, const char* name, float* data, size_t count) const {
+        MoonRay::PushFloatView(L, data, count);
+        lua_pushvalue(L, -1);
+        views.push_back(luaL_ref(L, LUA_REGISTRYINDEX));
+        lua_setfield(L, -2, name);
     }
 
-    void Draw() const override {
-        lua_getglobal(L, "OnRender");
-        if (lua_isfunction(L, -1)) {
-            if (lua_pcall(L, 0, 0, 0) != LUA_OK) {
-                lua_pop(L, 1);
-            }
-        } else {
+    // Scripts may have kept a view somewhere the VM outlives this component
+    void ClearViews() const {
+        lua_State* L = vm->State();
+        for (int ref : views) {
+            lua_rawgeti(L, LUA_REGISTRYINDEX, ref);
+            MoonRay::ClearFloatView(static_cast<MoonRay::FloatArray*>(lua_touserdata(L, -1)));
             lua_pop(L, 1);
-            lua_getglobal(L, "OnUpdate");
-            if (lua_isfunction(L, -1)) {
-                lua_pushnumber(L, 0.0f);
-                lua_pcall(L, 1, 0, 0);
-            } else { lua_pop(L, 1); }
+            luaL_unref(L, LUA_REGISTRYINDEX, ref);
         }
+        views.clear();
     }
 
+    // Ref to env[name] if it is a function, LUA_NOREF otherwise
+    int ResolveCallback(lua_State* L, const char* name) const {
+        lua_rawgeti(L, LUA_REGISTRYINDEX, env);
+        lua_getfield(L, -1, name);
+        lua_remove(L, -2);
+        if (lua_isfunction(L, -1)) return luaL_ref(L, LUA_REGISTRYINDEX);
+        lua_pop(L, 1);
+        return LUA_NOREF;
+    }
+
+    // Runs the callback on top of the stack, suspends the script if it went over budget
+    void Run(int nargs) const {
+        vm->Call(nargs, 0);
+        if (!vm->Overran()) return;
+        suspended = true;
+        std::cerr << "LUA: " << path << " suspended after going over its budget" << std::endl;
+    }
+
+    void ReleaseCallbacks() const {
+        vm->Release(onUpdate);
+        vm->Release(onRender);
+        onUpdate = onRender = LUA_NOREF;
+    }
+
+public:
+    LuaScriptComponent(std::string scriptPath, bool isolatedVM = false) : path(scriptPath), isolated(isolatedVM) {}
+
+    ~LuaScriptComponent() {
+        if (!vm) return;
+        if (isolatedScene) isolatedScene->RemoveIsolatedVM(vm);
+        ClearViews();
+        ReleaseCallbacks();
+        vm->Release(env);
+    }
+
+    // Looks OnUpdate/OnRender up again, e.g. after the script was reloaded, and lifts a budget
+    // suspension. Assigning a new OnUpdate from Lua at runtime is only picked up after this.
+    void ResolveCallbacks() const {
+        if (!vm) return;
+        ReleaseCallbacks();
+        suspended = false;
+        if (env == LUA_NOREF) return;
+
+        lua_State* L = vm->State();
+        onUpdate = ResolveCallback(L, "OnUpdate");
+        onRender = ResolveCallback(L, "OnRender");
+    }
+
+    bool HasUpdate() const { return onUpdate != LUA_NOREF; }
+    bool HasRender() const { return onRender != LUA_NOREF; }
+
+    void Draw() const override {
+        lua_State* L = Bind();
+        if (!L || onRender == LUA_NOREF || suspended) return;
+
+        lua_rawgeti(L, LUA_REGISTRYINDEX, onRender);
+        Run(0);
+    }
+
+    // OnRender runs while the queue is bound, so the script's draw calls are recorded
+    void Record(RenderQueue& queue) const override {
+        if (!Bind() || onRender == LUA_NOREF) return;
+        RecordingScope scope(queue);
+        Draw();
+    }
+
+    // Scripts share the scene VM and may call back into raylib (LoadTexture...), keep them off the workers
+    bool RecordsInParallel() const override { return false; }
+
+    // The first Update binds (runs the main chunk) on the calling thread
+    bool UpdatesInParallel() const override { return isolatedScene != nullptr; }
+
     void Update(float dt) override {
-        lua_getglobal(L, "OnUpdate");
-        if (lua_isfunction(L, -1)) {
-            lua_pushnumber(L, dt);
-            lua_pcall(L, 1, 0, 0);
-        } else { lua_pop(L, 1); }
+        if (ownVM) {
+            ownVM->ApplyReloads();
+            ownVM->RunCoroutines(dt);
+        }
+        lua_State* L = Bind();
+        if (!L || onUpdate == LUA_NOREF || suspended) return;
+
+        lua_rawgeti(L, LUA_REGISTRYINDEX, onUpdate);
+        lua_pushnumber(L, dt);
+        Run(1);
     }
 };
 
-#endif
\ No newline at end of file
+#endif
@@ -69,6 +69,9 @@ public:
 
     ~MaterialComponent() {
     }
+
+    // Data only, nothing to draw
+    void Record(RenderQueue& queue) const override {}
 };
 
 #endif
\ No newline at end of file
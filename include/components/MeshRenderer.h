@@ -21,37 +21,105 @@
 
 #include "core/Component.h"
 #include "core/GameObject.h"
+#include "core/Scene.h"
 #include "components/TransformComponent.h"
 #include "raylib.h"
+#include "raymath.h"
 #include "components/MaterialComponent.h"
+#include <vector>
+#include <cmath>
+#include <algorithm>
+
+struct MeshLOD {
+    Model model;
+    float screenSize;   // Used once the bounding sphere covers less than this fraction of the screen height
+};
 
 class MeshRenderer : public Component {
 private:
-    mutable Model model;
+    std::vector<MeshLOD> lods;
+    mutable size_t currentLod = 0;
+    Vector3 boundsCenter = { 0.0f, 0.0f, 0.0f };    // Bounding sphere around the model's box, model space
+    float boundsRadius = 0.0f;
+
+    // The packet's transform is the interpolated one that gets drawn
+    float ProjectedSize(const DrawPacket& packet) const {
+        Scene* scene = owner->GetScene();
+        if (!scene) return 1.0f;
+
+        const Camera3D& camera = scene->GetCamera();
+        float radius = boundsRadius * std::max(packet.size.x, std::max(packet.size.y, packet.size.z));
+        if (camera.projection == CAMERA_ORTHOGRAPHIC) return (radius * 2.0f) / camera.fovy;
+
+        Vector3 offset = Vector3RotateByAxisAngle(Vector3Multiply(boundsCenter, packet.size), packet.rotationAxis, packet.rotation * DEG2RAD);
+        float distance = Vector3Distance(camera.position, Vector3Add(packet.position, offset));
+        if (distance <= radius) return 1.0f;
+        return radius / (distance * tanf(camera.fovy * DEG2RAD * 0.5f));
+    }
+
+    const Model& SelectLOD(const DrawPacket& packet) const {
+        if (lods.size() > 1) {
+            float size = ProjectedSize(packet);
+            size_t lod = currentLod;
+            // Hysteresis band around each threshold keeps objects near a boundary from popping
+            while (lod + 1 < lods.size() && size < lods[lod + 1].screenSize * (1.0f - lodHysteresis)) lod++;
+            while (lod > 0 && size > lods[lod].screenSize * (1.0f + lodHysteresis)) lod--;
+            currentLod = lod;
+        }
+        return lods[currentLod].model;
+    }
 
 public:
-    MeshRenderer(Model mdl) : model(mdl) {}
+    float lodHysteresis = 0.1f;
 
-    void Draw() const override {
+    MeshRenderer(Model mdl) {
+        lods.push_back({ mdl, 1.0f });
+        BoundingBox box = GetModelBoundingBox(mdl);
+        boundsCenter = Vector3Scale(Vector3Add(box.min, box.max), 0.5f);
+        boundsRadius = Vector3Distance(box.min, box.max) * 0.5f;
+    }
+
+    // Registers a coarser model, e.g. from MoonRay::GenerateLODModel() or tools/LodGen.
+    void AddLOD(Model mdl, float screenSize) {
+        lods.push_back({ mdl, screenSize });
+        std::stable_sort(lods.begin() + 1, lods.end(), [](const MeshLOD& a, const MeshLOD& b) {
+            return a.screenSize > b.screenSize;
+        });
+    }
+
+    size_t GetLODCount() const { return lods.size(); }
+    size_t GetCurrentLOD() const { return currentLod; }
+
+    bool BuildPacket(DrawPacket& packet) const {
         TransformComponent* transform = owner->GetComponent<TransformComponent>();
+        if (!transform) return false;
 
         MaterialComponent* matComp = owner->GetComponent<MaterialComponent>();
 
-        if (transform) {
-            
-            if (matComp) {
-                model.materials[0] = matComp->material;
-                DrawModelEx(model,
-                            transform->position,
-                            transform->rotationAxis,
-                            transform->rotationAngle,
-                            transform->scale,
-                            WHITE); 
-            } else {
-                DrawModelEx(model, transform->position, transform->rotationAxis,
-                            transform->rotationAngle, transform->scale, WHITE);
-            }
+        float alpha = owner->GetScene() ? owner->GetScene()->GetInterpolationAlpha() : 1.0f;
+
+        packet.command = DrawCommand::Model;
+        if (matComp) {
+            packet.material = matComp->material;
+            packet.hasMaterial = true;
         }
+        packet.position = transform->InterpolatedPosition(alpha);
+        packet.rotationAxis = transform->rotationAxis;
+        packet.rotation = transform->InterpolatedRotationAngle(alpha);
+        packet.size = transform->InterpolatedScale(alpha);
+        packet.color = WHITE;
+        packet.model = &SelectLOD(packet);
+        return true;
+    }
+
+    void Draw() const override {
+        DrawPacket packet;
+        if (BuildPacket(packet)) RenderQueue::Execute(packet, nullptr);
+    }
+
+    void Record(RenderQueue& queue) const override {
+        DrawPacket packet;
+        if (BuildPacket(packet)) queue.Push(packet);
     }
 };
 
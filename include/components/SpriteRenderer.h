@@ -20,6 +20,7 @@
 
 #include "core/Component.h"
 #include "core/GameObject.h"
+#include "core/Scene.h"
 #include "components/Transform2D.h"
 #include "raylib.h"
 
@@ -30,20 +31,37 @@ public:
 
     SpriteRenderer(Texture2D tex, Color color = WHITE) : texture(tex), tint(color) {}
 
-    void Draw() const override {
+    bool BuildPacket(DrawPacket& packet) const {
         auto* t2d = owner->GetComponent<Transform2DComponent>();
-        if (t2d) {
-            Rectangle source = { 0.0f, 0.0f, (float)texture.width, (float)texture.height };
-            Rectangle dest = {
-                t2d->position.x,
-                t2d->position.y,
-                (float)texture.width * t2d->scale.x,
-                (float)texture.height * t2d->scale.y
-            };
-            Vector2 origin = { dest.width / 2.0f, dest.height / 2.0f };
-
-            DrawTexturePro(texture, source, dest, origin, t2d->rotation, tint);
-        }
+        if (!t2d) return false;
+
+        float alpha = owner->GetScene() ? owner->GetScene()->GetInterpolationAlpha() : 1.0f;
+        Vector2 position = t2d->InterpolatedPosition(alpha);
+        Vector2 scale = t2d->InterpolatedScale(alpha);
+
+        packet.command = DrawCommand::TexturePro;
+        packet.texture = texture;
+        packet.source = { 0.0f, 0.0f, (float)texture.width, (float)texture.height };
+        packet.dest = {
+            position.x,
+            position.y,
+            (float)texture.width * scale.x,
+            (float)texture.height * scale.y
+        };
+        packet.origin = { packet.dest.width / 2.0f, packet.dest.height / 2.0f };
+        packet.rotation = t2d->InterpolatedRotation(alpha);
+        packet.color = tint;
+        return true;
+    }
+
+    void Draw() const override {
+        DrawPacket packet;
+        if (BuildPacket(packet)) RenderQueue::Execute(packet, nullptr);
+    }
+
+    void Record(RenderQueue& queue) const override {
+        DrawPacket packet;
+        if (BuildPacket(packet)) queue.Push(packet);
     }
 };
 
@@ -20,17 +20,45 @@
 #define TRANSFORM_2D_H
 
 #include "core/Component.h"
+#include "core/FixedTimestep.h"
 #include "raylib.h"
+#include "raymath.h"
+#include <cstddef>
 
 class Transform2DComponent : public Component {
 public:
+    // position, rotation and scale are FloatCount consecutive floats, the `transform2D` view of scripts
+    static constexpr size_t FloatCount = 5;
+
     Vector2 position;
     float rotation;   
     Vector2 scale;
     int zIndex;       
 
+    Vector2 previousPosition;
+    float previousRotation;
+    Vector2 previousScale;
+
     Transform2DComponent(Vector2 pos = {0, 0}, float rot = 0, Vector2 scl = {1, 1}, int z = 0)
-        : position(pos), rotation(rot), scale(scl), zIndex(z) {}
+        : position(pos), rotation(rot), scale(scl), zIndex(z),
+          previousPosition(pos), previousRotation(rot), previousScale(scl) {}
+
+    void StorePreviousState() override {
+        previousPosition = position;
+        previousRotation = rotation;
+        previousScale = scale;
+    }
+
+    void ResetInterpolation() { StorePreviousState(); }
+
+    Vector2 InterpolatedPosition(float alpha) const { return Vector2Lerp(previousPosition, position, alpha); }
+    float InterpolatedRotation(float alpha) const { return LerpAngle(previousRotation, rotation, alpha); }
+    Vector2 InterpolatedScale(float alpha) const { return Vector2Lerp(previousScale, scale, alpha); }
+
+    float* Data() { return &position.x; }
+
+    // Data only, nothing to draw
+    void Record(RenderQueue& queue) const override {}
 };
 
 #endif
\ No newline at end of file
@@ -20,23 +20,54 @@
 #define TRANSFORM_H
 
 #include "core/Component.h"
+#include "core/FixedTimestep.h"
 #include "raylib.h"
+#include "raymath.h"
+#include <cstddef>
 
 class TransformComponent : public Component {
 public:
+    // position, rotationAxis, rotationAngle and scale are FloatCount consecutive floats, which
+    // scripts see as their `transform` FloatArray view
+    static constexpr size_t FloatCount = 10;
+
     Vector3 position;
     Vector3 rotationAxis;
     float rotationAngle;
     Vector3 scale;
 
+    // State at the previous simulation tick, used for render interpolation
+    Vector3 previousPosition;
+    float previousRotationAngle;
+    Vector3 previousScale;
+
     TransformComponent(Vector3 pos = {0,0,0}, Vector3 rotAxis = {0,1,0}, float angle = 0, Vector3 scl = {1,1,1})
-        : position(pos), rotationAxis(rotAxis), rotationAngle(angle), scale(scl) {}
+        : position(pos), rotationAxis(rotAxis), rotationAngle(angle), scale(scl),
+          previousPosition(pos), previousRotationAngle(angle), previousScale(scl) {}
+
+    void StorePreviousState() override {
+        previousPosition = position;
+        previousRotationAngle = rotationAngle;
+        previousScale = scale;
+    }
+
+    // Call after teleporting so the renderer does not blend across the jump
+    void ResetInterpolation() { StorePreviousState(); }
+
+    Vector3 InterpolatedPosition(float alpha) const { return Vector3Lerp(previousPosition, position, alpha); }
+    float InterpolatedRotationAngle(float alpha) const { return LerpAngle(previousRotationAngle, rotationAngle, alpha); }
+    Vector3 InterpolatedScale(float alpha) const { return Vector3Lerp(previousScale, scale, alpha); }
 
     void Translate(Vector3 delta) {
         position.x += delta.x;
         position.y += delta.y;
         position.z += delta.z;
     }
+
+    float* Data() { return &position.x; }
+
+    // Data only, nothing to draw
+    void Record(RenderQueue& queue) const override {}
 };
 
 #endif
\ No newline at end of file
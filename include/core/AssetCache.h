@@ -0,0 +1,126 @@
+/*
+ * Copyright (C) 2026 Artem Svitlov (Moscow, Russia)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// Textures shared by path. Every AcquireTexture() takes a reference, ReleaseTexture() drops
+// it (any thread, Lua __gc included). Collect() runs once per frame after recording and unloads
+// a texture nobody has referenced for IdleCollects calls: one released while frame N was
+// updated may still be drawn by frame N, which is only sure to be replayed once frame N + 2 has
+// been recorded. Acquiring it again before that keeps it.
+
+#ifndef ASSET_CACHE_H
+#define ASSET_CACHE_H
+
+#include "raylib.h"
+#include "core/RenderQueue.h"
+#include <string>
+#include <unordered_map>
+#include <vector>
+#include <mutex>
+
+class AssetCache {
+private:
+    struct TextureEntry {
+        Texture2D texture = { 0 };
+        int references = 0;
+        int idleCollects = 0;       // Collect() calls since the last reference was dropped
+    };
+
+    std::mutex mutex;
+    std::unordered_map<std::string, TextureEntry> textures;
+    std::unordered_map<unsigned int, std::string> paths;    // Texture id -> key in textures
+
+    // Takes a reference on a cached texture, nullptr if the path isn't loaded. Called locked.
+    TextureEntry* Reference(const std::string& path) {
+        auto it = textures.find(path);
+        if (it == textures.end()) return nullptr;
+        it->second.references++;
+        it->second.idleCollects = 0;
+        return &it->second;
+    }
+
+public:
+    static constexpr int IdleCollects = 3;
+
+    static AssetCache& Get() {
+        static AssetCache cache;
+        return cache;
+    }
+
+    // Loads on the render thread the first time, without holding the lock. A file that fails
+    // to load (id 0) isn't cached. If another thread loaded the same path meanwhile, its texture
+    // is shared and this copy unloaded.
+    Texture2D AcquireTexture(const std::string& path) {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (TextureEntry* entry = Reference(path)) return entry->texture;
+        }
+
+        Texture2D texture = { 0 };
+        MoonRay::RunOnRenderThread([&] { texture = LoadTexture(path.c_str()); });
+        if (texture.id == 0) return texture;
+
+        Texture2D loaded = texture;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            if (TextureEntry* entry = Reference(path)) {
+                texture = entry->texture;
+            } else {
+                TextureEntry& added = textures[path];
+                added.texture = texture;
+                added.references = 1;
+                paths[texture.id] = path;
+                return texture;
+            }
+        }
+        MoonRay::RunOnRenderThread([&] { UnloadTexture(loaded); });
+        return texture;
+    }
+
+    // Drops a reference. Returns false if the id isn't a cached texture.
+    bool ReleaseTexture(unsigned int id) {
+        std::lock_guard<std::mutex> lock(mutex);
+        auto path = paths.find(id);
+        if (path == paths.end()) return false;
+        TextureEntry& entry = textures[path->second];
+        if (entry.references > 0) entry.references--;
+        return true;
+    }
+
+    // Unloads textures that have been unreferenced for IdleCollects calls
+    void Collect() {
+        std::vector<Texture2D> unused;
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            for (auto it = textures.begin(); it != textures.end();) {
+                TextureEntry& entry = it->second;
+                if (entry.references > 0 || ++entry.idleCollects < IdleCollects) { ++it; continue; }
+                unused.push_back(entry.texture);
+                paths.erase(entry.texture.id);
+                it = textures.erase(it);
+            }
+        }
+        if (unused.empty()) return;
+        MoonRay::RunOnRenderThread([&] { for (const Texture2D& texture : unused) UnloadTexture(texture); });
+    }
+
+    size_t TextureCount() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return textures.size();
+    }
+};
+
+#endif
@@ -0,0 +1,70 @@
+/*
+ * Copyright (C) 2026 Artem Svitlov (Moscow, Russia)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// Engine calls made on a worker thread that have to happen on the thread updating the scene
+// (window, audio, GL). While a CommandQueue is bound on a thread (CommandScope), the Lua
+// bindings append those calls to it through MoonRay::RunOnMainThread(); Scene applies the
+// queues after the parallel update, in object order.
+
+#ifndef COMMAND_QUEUE_H
+#define COMMAND_QUEUE_H
+
+#include <vector>
+#include <functional>
+
+class CommandQueue {
+private:
+    std::vector<std::function<void()>> commands;
+
+public:
+    void Push(std::function<void()> command) { commands.push_back(std::move(command)); }
+    bool Empty() const { return commands.empty(); }
+
+    void Apply() {
+        for (auto& command : commands) command();
+        commands.clear();
+    }
+
+    // Queue bound on this thread, nullptr on the thread that owns the scene
+    static CommandQueue*& Bound() {
+        static thread_local CommandQueue* current = nullptr;
+        return current;
+    }
+};
+
+class CommandScope {
+private:
+    CommandQueue* previous;
+
+public:
+    explicit CommandScope(CommandQueue& queue) : previous(CommandQueue::Bound()) {
+        CommandQueue::Bound() = &queue;
+    }
+    ~CommandScope() { CommandQueue::Bound() = previous; }
+};
+
+namespace MoonRay {
+    inline bool OnWorkerThread() { return CommandQueue::Bound() != nullptr; }
+
+    // Runs the task now, or queues it when called from a parallel update
+    inline void RunOnMainThread(std::function<void()> task) {
+        if (CommandQueue* queue = CommandQueue::Bound()) queue->Push(std::move(task));
+        else task();
+    }
+}
+
+#endif
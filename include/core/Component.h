@@ -19,6 +19,8 @@
 #ifndef COMPONENT_H
 #define COMPONENT_H
 
+#include "core/RenderQueue.h"
+
 class GameObject; 
 
 class Component {
@@ -29,7 +31,27 @@ public:
     void SetOwner(GameObject* entity) { owner = entity; }
     
     virtual void Update(float deltaTime) {}
+
+    // Called before every fixed simulation tick, keeps the state renderers interpolate from
+    virtual void StorePreviousState() {}
     virtual void Draw() const {}
+
+    // Default: replay Draw() when the queue is submitted. Components whose Draw() reads
+    // mutable state should record real packets instead (required for the render thread).
+    virtual void Record(RenderQueue& queue) const {
+        DrawPacket packet;
+        packet.command = DrawCommand::Custom;
+        packet.callback = [](const void* object) { static_cast<const Component*>(object)->Draw(); };
+        packet.object = this;
+        queue.Push(packet);
+    }
+
+    // False for components that must be recorded on the thread calling Scene::Record
+    virtual bool RecordsInParallel() const { return true; }
+
+    // True for components whose Update() only touches their own state; Scene runs those on the
+    // job system before the serial updates
+    virtual bool UpdatesInParallel() const { return false; }
 };
 
 #endif
\ No newline at end of file
@@ -0,0 +1,64 @@
+/*
+ * Copyright (C) 2026 Artem Svitlov (Moscow, Russia)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// Fixed tick accumulator. The simulation always advances by Step(), rendering interpolates
+// between the last two ticks with Alpha().
+
+#ifndef FIXED_TIMESTEP_H
+#define FIXED_TIMESTEP_H
+
+#include <cmath>
+
+class FixedTimestep {
+private:
+    double step;
+    double accumulator = 0.0;
+    int maxTicks;
+
+public:
+    // maxTicksPerFrame caps the catch-up after a hitch (spiral of death); the rest is dropped
+    explicit FixedTimestep(int ticksPerSecond = 60, int maxTicksPerFrame = 5)
+        : step(1.0 / (ticksPerSecond > 0 ? ticksPerSecond : 60)), maxTicks(maxTicksPerFrame) {}
+
+    float Step() const { return (float)step; }
+
+    // Adds the frame time and returns how many ticks to run this frame
+    int Advance(float frameTime) {
+        accumulator += frameTime;
+
+        int ticks = (int)(accumulator / step);
+        if (ticks > maxTicks) {
+            ticks = maxTicks;
+            accumulator = step * maxTicks;
+        }
+        accumulator -= ticks * step;
+        return ticks;
+    }
+
+    // How far the render time is between the previous and the current tick, [0, 1)
+    float Alpha() const { return (float)(accumulator / step); }
+};
+
+// Blends two angles in degrees along the shorter arc, so an angle that wraps (359 to 1) doesn't
+// spin the other way round for a frame
+inline float LerpAngle(float from, float to, float alpha) {
+    float delta = std::fmod(to - from + 180.0f, 360.0f);
+    if (delta < 0.0f) delta += 360.0f;
+    return from + (delta - 180.0f) * alpha;
+}
+
+#endif
@@ -0,0 +1,206 @@
+/*
+ * Copyright (C) 2026 Artem Svitlov (Moscow, Russia)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// Double-buffered hand-off between the simulation (producer) and the thread that owns the
+// GL context (consumer). The producer records frame N+1 while the consumer replays frame N;
+// a RenderFrame is an immutable snapshot once published.
+//
+// EndDrawing() polls input, so the consumer calls WaitForNextFrame() before it. That keeps
+// every raylib input/time query made by the producer between BeginFrame() and EndFrame()
+// race free.
+
+#ifndef FRAME_PIPELINE_H
+#define FRAME_PIPELINE_H
+
+#include "raylib.h"
+#include "Imgui/rlImGui.h"
+#include "core/RenderQueue.h"
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <functional>
+#include <vector>
+#include <cstdint>
+
+struct RenderFrame {
+    Camera3D camera = {};
+    Camera2D camera2D = {};
+    Color clearColor = BLACK;
+    RenderQueue world;      // Drawn inside BeginMode3D
+    RenderQueue overlay;    // Drawn inside BeginMode2D
+};
+
+// Everything up to (not including) EndDrawing(). gui runs inside the ImGui frame.
+inline void ReplayFrame(const RenderFrame& frame, const std::function<void()>& gui = nullptr) {
+    BeginDrawing();
+        ClearBackground(frame.clearColor);
+
+        BeginMode3D(frame.camera);
+            frame.world.Submit();
+        EndMode3D();
+
+        BeginMode2D(frame.camera2D);
+            frame.overlay.Submit();
+        EndMode2D();
+
+        rlImGuiBegin();
+            if (gui) gui();
+        rlImGuiEnd();
+}
+
+class FramePipeline {
+private:
+    std::mutex mutex;
+    std::condition_variable signal;
+
+    RenderFrame frames[2];
+    uint64_t published = 0;     // Frames recorded by the producer
+    uint64_t presented = 0;     // Frames finished with EndDrawing (input polled)
+    bool stopping = false;
+
+    std::thread::id consumer;
+    bool consumerBound = false;
+    std::vector<std::function<void()>> tasks;
+    uint64_t tasksQueued = 0;
+    uint64_t tasksTaken = 0;
+
+    // Waits for the condition while running Invoke() requests from the producer
+    template <typename Pred>
+    void WaitServicingTasks(std::unique_lock<std::mutex>& lock, Pred done) {
+        while (true) {
+            signal.wait(lock, [&] { return done() || stopping || !tasks.empty(); });
+            if (stopping || tasks.empty()) return;
+
+            std::vector<std::function<void()>> pending;
+            pending.swap(tasks);
+            tasksTaken = tasksQueued;
+            lock.unlock();
+            for (auto& task : pending) task();
+            signal.notify_all();
+            lock.lock();
+        }
+    }
+
+public:
+    FramePipeline() = default;
+
+    ~FramePipeline() {
+        if (consumerBound) MoonRay::RenderThreadInvoker() = nullptr;
+    }
+
+    FramePipeline(const FramePipeline&) = delete;
+    FramePipeline& operator=(const FramePipeline&) = delete;
+
+    // Called on the thread that owns the GL context, after the window exists
+    void BindConsumer() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            consumer = std::this_thread::get_id();
+            consumerBound = true;
+        }
+        MoonRay::RenderThreadInvoker() = [this](const std::function<void()>& task) { Invoke(task); };
+        signal.notify_all();
+    }
+
+    void WaitForConsumer() {
+        std::unique_lock<std::mutex> lock(mutex);
+        signal.wait(lock, [this] { return consumerBound || stopping; });
+    }
+
+    void Stop() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        signal.notify_all();
+    }
+
+    bool Stopping() {
+        std::lock_guard<std::mutex> lock(mutex);
+        return stopping;
+    }
+
+    // --- Producer ---
+
+    // Frame to record into, nullptr once the pipeline is stopping. Blocks while the
+    // consumer is more than one frame behind.
+    RenderFrame* BeginFrame() {
+        std::unique_lock<std::mutex> lock(mutex);
+        signal.wait(lock, [this] { return stopping || presented + 1 >= published; });
+        if (stopping) return nullptr;
+
+        RenderFrame& frame = frames[published % 2];
+        frame.world.Clear();
+        frame.overlay.Clear();
+        return &frame;
+    }
+
+    void EndFrame() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            published++;
+        }
+        signal.notify_all();
+    }
+
+    // --- Consumer ---
+
+    // Next frame to replay, nullptr once the pipeline is stopping
+    const RenderFrame* AcquireFrame() {
+        std::unique_lock<std::mutex> lock(mutex);
+        WaitServicingTasks(lock, [this] { return published > presented; });
+        if (stopping) return nullptr;
+        return &frames[presented % 2];
+    }
+
+    // Call right before EndDrawing(): waits until the producer is done with input for the next frame
+    void WaitForNextFrame() {
+        std::unique_lock<std::mutex> lock(mutex);
+        WaitServicingTasks(lock, [this] { return published > presented + 1; });
+    }
+
+    void FramePresented() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            presented++;
+        }
+        signal.notify_all();
+    }
+
+    // Runs a task on the consumer thread (GL resource creation etc.) and waits for it.
+    // Returns without running it if the pipeline stops first.
+    void Invoke(const std::function<void()>& task) {
+        std::unique_lock<std::mutex> lock(mutex);
+        if (!consumerBound || std::this_thread::get_id() == consumer) {
+            lock.unlock();
+            task();
+            return;
+        }
+
+        bool done = false;
+        uint64_t ticket = tasksQueued++;
+        tasks.push_back([&] {
+            task();
+            std::lock_guard<std::mutex> doneLock(mutex);
+            done = true;
+        });
+        signal.notify_all();
+        signal.wait(lock, [&] { return done || (stopping && tasksTaken <= ticket); });
+    }
+};
+
+#endif
@@ -24,18 +24,38 @@
 #include <algorithm>
 #include "core/Component.h"
 
+class Scene;
+
+enum class RecordFilter {
+    All,
+    Parallel,   // Only components that can record on a worker thread
+    Serial      // Only components that must record on the calling thread
+};
+
+enum class UpdateFilter {
+    All,
+    Parallel,   // Only components that update on a worker thread
+    Serial
+};
+
 class GameObject {
 private:
     std::vector<std::unique_ptr<Component>> components;
+    Scene* scene = nullptr;
+    bool serialRecord = false;
 
 public:
     GameObject() = default;
+
+    void SetScene(Scene* owningScene) { scene = owningScene; }
+    Scene* GetScene() const { return scene; }
     
     template <typename T, typename... TArgs>
     T& AddComponent(TArgs&&... args) {
         auto comp = std::make_unique<T>(std::forward<TArgs>(args)...);
         comp->SetOwner(this);
         T& reference = *comp;
+        if (!comp->RecordsInParallel()) serialRecord = true;
         components.push_back(std::move(comp));
         return reference;
     }
@@ -49,13 +69,45 @@ public:
         return nullptr;
     }
 
-    void Update(float deltaTime) {
-        for (auto& comp : components) comp->Update(deltaTime);
+    void Update(float deltaTime, UpdateFilter filter = UpdateFilter::All) {
+        for (auto& comp : components) {
+            if (filter != UpdateFilter::All && comp->UpdatesInParallel() != (filter == UpdateFilter::Parallel)) continue;
+            comp->Update(deltaTime);
+        }
+    }
+
+    // Asked every frame: a component may only become parallel once it is set up
+    bool HasParallelUpdate() const {
+        for (const auto& comp : components) {
+            if (comp->UpdatesInParallel()) return true;
+        }
+        return false;
+    }
+
+    void StorePreviousState() {
+        for (auto& comp : components) comp->StorePreviousState();
     }
 
     void Render() const {
         for (const auto& comp : components) comp->Draw();
     }
+
+    bool HasSerialRecord() const { return serialRecord; }
+
+    void Record(RenderQueue& queue) const {
+        for (const auto& comp : components) comp->Record(queue);
+    }
+
+    // One pass of a split recording. The packets of component i get key | i (the low 8 bits
+    // are left free for it), so merging the parallel and serial passes restores component order.
+    void Record(RenderQueue& queue, RecordFilter filter, uint64_t key) const {
+        for (size_t i = 0; i < components.size(); i++) {
+            const auto& comp = components[i];
+            if (filter != RecordFilter::All && comp->RecordsInParallel() != (filter == RecordFilter::Parallel)) continue;
+            queue.SetSortKey(key | std::min<size_t>(i, 0xFF));
+            comp->Record(queue);
+        }
+    }
 };
 
 #endif
\ No newline at end of file
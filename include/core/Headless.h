@@ -0,0 +1,33 @@
+/*
+ * Copyright (C) 2026 Artem Svitlov (Moscow, Russia)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// Headless (dedicated server) build: compiled with MOONRAY_HEADLESS and linked against the
+// null platform in src/server/NullPlatform.cpp instead of raylib, so there is no window and no GL.
+// Draw packets are dropped, input queries report nothing pressed and the clock is driven by the
+// server loop.
+
+#ifndef HEADLESS_H
+#define HEADLESS_H
+
+namespace MoonRay {
+    namespace Headless {
+        // Value returned by GetFrameTime() (the server tick step)
+        void SetFrameTime(float seconds);
+    }
+}
+
+#endif
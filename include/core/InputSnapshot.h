@@ -0,0 +1,138 @@
+/*
+ * Copyright (C) 2026 Artem Svitlov (Moscow, Russia)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// Input state captured once per frame. Capture() queries raylib at the start of the frame, on
+// the thread that runs the simulation (inside BeginFrame/EndFrame in the threaded modes, see
+// FramePipeline), and every script VM reads the same copy: isolated scripts on the job system
+// included, and without a raylib call per query.
+//
+// A capture fills the oldest of three buffers and then publishes it through an atomic pointer,
+// so Current() always returns a complete snapshot that doesn't change for two more frames.
+
+#ifndef INPUT_SNAPSHOT_H
+#define INPUT_SNAPSHOT_H
+
+#include "raylib.h"
+#include <cstdint>
+#include <atomic>
+
+struct InputSnapshot {
+    static constexpr int KeyCount = 512;            // raylib's MAX_KEYBOARD_KEYS
+    static constexpr int MouseButtonCount = MOUSE_BUTTON_BACK + 1;
+    static constexpr int GamepadCount = 4;
+    static constexpr int GamepadAxisCount = GAMEPAD_AXIS_RIGHT_TRIGGER + 1;
+    static constexpr int GamepadButtonCount = GAMEPAD_BUTTON_RIGHT_THUMB + 1;
+
+    uint64_t frame = 0;                             // Captures so far, 0 = never captured
+
+    uint64_t keysDown[KeyCount / 64] = {};
+    uint64_t keysPressed[KeyCount / 64] = {};
+    uint64_t keysReleased[KeyCount / 64] = {};
+
+    uint32_t mouseDown = 0;                         // Bit per mouse button
+    uint32_t mousePressed = 0;
+    uint32_t mouseReleased = 0;
+    Vector2 mousePosition = { 0.0f, 0.0f };
+    Vector2 mouseDelta = { 0.0f, 0.0f };
+    float mouseWheel = 0.0f;
+
+    uint32_t gamepads = 0;                          // Bit per available gamepad
+    uint32_t gamepadDown[GamepadCount] = {};        // Bit per button
+    float gamepadAxes[GamepadCount][GamepadAxisCount] = {};
+
+    static bool Bit(const uint64_t* bits, int index) {
+        return index >= 0 && index < KeyCount && (bits[index / 64] >> (index % 64)) & 1;
+    }
+
+    static bool Bit(uint32_t bits, int index, int count) {
+        return index >= 0 && index < count && (bits >> index) & 1;
+    }
+
+    bool KeyDown(int key) const { return Bit(keysDown, key); }
+    bool KeyPressed(int key) const { return Bit(keysPressed, key); }
+    bool KeyReleased(int key) const { return Bit(keysReleased, key); }
+
+    bool MouseDown(int button) const { return Bit(mouseDown, button, MouseButtonCount); }
+    bool MousePressed(int button) const { return Bit(mousePressed, button, MouseButtonCount); }
+    bool MouseReleased(int button) const { return Bit(mouseReleased, button, MouseButtonCount); }
+
+    bool GamepadAvailable(int gamepad) const { return Bit(gamepads, gamepad, GamepadCount); }
+    bool GamepadDown(int gamepad, int button) const {
+        return GamepadAvailable(gamepad) && Bit(gamepadDown[gamepad], button, GamepadButtonCount);
+    }
+    float GamepadAxis(int gamepad, int axis) const {
+        if (!GamepadAvailable(gamepad) || axis < 0 || axis >= GamepadAxisCount) return 0.0f;
+        return gamepadAxes[gamepad][axis];
+    }
+
+    // All zero until Capture() has run
+    static const InputSnapshot& Current() { return *Published().load(std::memory_order_acquire); }
+    static bool Captured() { return Current().frame != 0; }
+
+    // Once per frame, before the scenes update, always from the same thread
+    static void Capture() {
+        uint64_t frame = Published().load(std::memory_order_relaxed)->frame + 1;
+        InputSnapshot& input = Buffers()[frame % BufferCount];
+        input = InputSnapshot();
+        input.frame = frame;
+
+        for (int key = 0; key < KeyCount; key++) {
+            uint64_t bit = 1ull << (key % 64);
+            if (IsKeyDown(key)) input.keysDown[key / 64] |= bit;
+            if (IsKeyPressed(key)) input.keysPressed[key / 64] |= bit;
+            if (IsKeyReleased(key)) input.keysReleased[key / 64] |= bit;
+        }
+
+        for (int button = 0; button < MouseButtonCount; button++) {
+            if (IsMouseButtonDown(button)) input.mouseDown |= 1u << button;
+            if (IsMouseButtonPressed(button)) input.mousePressed |= 1u << button;
+            if (IsMouseButtonReleased(button)) input.mouseReleased |= 1u << button;
+        }
+        input.mousePosition = GetMousePosition();
+        input.mouseDelta = GetMouseDelta();
+        input.mouseWheel = GetMouseWheelMove();
+
+        for (int gamepad = 0; gamepad < GamepadCount; gamepad++) {
+            if (!IsGamepadAvailable(gamepad)) continue;
+            input.gamepads |= 1u << gamepad;
+            for (int button = 0; button < GamepadButtonCount; button++) {
+                if (IsGamepadButtonDown(gamepad, button)) input.gamepadDown[gamepad] |= 1u << button;
+            }
+            for (int axis = 0; axis < GamepadAxisCount; axis++) {
+                input.gamepadAxes[gamepad][axis] = GetGamepadAxisMovement(gamepad, axis);
+            }
+        }
+
+        Published().store(&input, std::memory_order_release);
+    }
+
+private:
+    static constexpr int BufferCount = 3;
+
+    // Frame n is written to buffer n % BufferCount, buffer 0 starts out as the empty frame 0
+    static InputSnapshot* Buffers() {
+        static InputSnapshot buffers[BufferCount];
+        return buffers;
+    }
+
+    static std::atomic<const InputSnapshot*>& Published() {
+        static std::atomic<const InputSnapshot*> published{ &Buffers()[0] };
+        return published;
+    }
+};
+
+#endif
@@ -0,0 +1,127 @@
+/*
+ * Copyright (C) 2026 Artem Svitlov (Moscow, Russia)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// Small fork/join worker pool. ParallelFor() hands out indices to the workers and the
+// calling thread, and returns once every index has been processed.
+
+#ifndef JOB_SYSTEM_H
+#define JOB_SYSTEM_H
+
+#include <thread>
+#include <mutex>
+#include <condition_variable>
+#include <atomic>
+#include <functional>
+#include <vector>
+#include <cstdint>
+
+class JobSystem {
+private:
+    std::vector<std::thread> workers;
+    std::mutex mutex;
+    std::mutex submitMutex;     // One ParallelFor at a time per pool
+    std::condition_variable wake;
+    std::condition_variable finished;
+
+    const std::function<void(size_t)>* job = nullptr;
+    size_t jobCount = 0;
+    std::atomic<size_t> nextIndex{ 0 };
+    size_t busyWorkers = 0;
+    uint64_t generation = 0;
+    bool stopping = false;
+
+    static bool& InsideJob() {
+        static thread_local bool inside = false;
+        return inside;
+    }
+
+    void Drain(const std::function<void(size_t)>& fn, size_t count) {
+        InsideJob() = true;
+        for (size_t i = nextIndex++; i < count; i = nextIndex++) fn(i);
+        InsideJob() = false;
+    }
+
+    void WorkerMain() {
+        uint64_t seen = 0;
+        std::unique_lock<std::mutex> lock(mutex);
+        while (true) {
+            wake.wait(lock, [&] { return stopping || generation != seen; });
+            if (stopping) return;
+            seen = generation;
+            if (!job) continue;     // Woke up after that ParallelFor already finished
+
+            const std::function<void(size_t)>* fn = job;
+            size_t count = jobCount;
+            busyWorkers++;
+            lock.unlock();
+
+            Drain(*fn, count);
+
+            lock.lock();
+            if (--busyWorkers == 0) finished.notify_all();
+        }
+    }
+
+public:
+    explicit JobSystem(size_t threads = std::thread::hardware_concurrency()) {
+        // The calling thread takes part in every ParallelFor, so spawn one less
+        size_t spawn = threads > 1 ? threads - 1 : 0;
+        for (size_t i = 0; i < spawn; i++) workers.emplace_back([this] { WorkerMain(); });
+    }
+
+    ~JobSystem() {
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            stopping = true;
+        }
+        wake.notify_all();
+        for (auto& worker : workers) worker.join();
+    }
+
+    JobSystem(const JobSystem&) = delete;
+    JobSystem& operator=(const JobSystem&) = delete;
+
+    size_t WorkerCount() const { return workers.size() + 1; }
+
+    // Calls fn(i) for every i in [0, count). Nested calls from inside a job run inline.
+    void ParallelFor(size_t count, const std::function<void(size_t)>& fn) {
+        if (count == 0) return;
+        if (workers.empty() || count == 1 || InsideJob()) {
+            for (size_t i = 0; i < count; i++) fn(i);
+            return;
+        }
+
+        std::lock_guard<std::mutex> submit(submitMutex);
+        {
+            std::lock_guard<std::mutex> lock(mutex);
+            job = &fn;
+            jobCount = count;
+            nextIndex = 0;
+            generation++;
+        }
+        wake.notify_all();
+
+        Drain(fn, count);
+
+        // Workers that picked up this generation must be done before fn goes out of scope
+        std::unique_lock<std::mutex> lock(mutex);
+        finished.wait(lock, [&] { return busyWorkers == 0; });
+        job = nullptr;
+    }
+};
+
+#endif
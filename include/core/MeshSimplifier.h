@@ -0,0 +1,308 @@
+/*
+ * Copyright (C) 2026 Artem Svitlov (Moscow, Russia)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// Quadric error mesh simplification (Garland & Heckbert) used to build LOD chains.
+// Works on the CPU copy of the mesh, so it can run offline (tools/LodGen.cpp) or at load time.
+
+#ifndef MESH_SIMPLIFIER_H
+#define MESH_SIMPLIFIER_H
+
+#include "raylib.h"
+#include "raymath.h"
+#include <vector>
+#include <array>
+#include <queue>
+#include <unordered_map>
+#include <cstring>
+#include <cstdint>
+
+#ifndef MAX_MATERIAL_MAPS
+#define MAX_MATERIAL_MAPS 12    // Must match raylib config.h, DrawMesh() walks this many maps
+#endif
+
+namespace MoonRay {
+
+    struct Quadric {
+        double a2 = 0, ab = 0, ac = 0, ad = 0;
+        double b2 = 0, bc = 0, bd = 0;
+        double c2 = 0, cd = 0;
+        double d2 = 0;
+
+        static Quadric FromPlane(double a, double b, double c, double d, double weight) {
+            Quadric q;
+            q.a2 = a * a * weight; q.ab = a * b * weight; q.ac = a * c * weight; q.ad = a * d * weight;
+            q.b2 = b * b * weight; q.bc = b * c * weight; q.bd = b * d * weight;
+            q.c2 = c * c * weight; q.cd = c * d * weight;
+            q.d2 = d * d * weight;
+            return q;
+        }
+
+        Quadric& operator+=(const Quadric& o) {
+            a2 += o.a2; ab += o.ab; ac += o.ac; ad += o.ad;
+            b2 += o.b2; bc += o.bc; bd += o.bd;
+            c2 += o.c2; cd += o.cd;
+            d2 += o.d2;
+            return *this;
+        }
+
+        double Error(Vector3 v) const {
+            double x = v.x, y = v.y, z = v.z;
+            return a2 * x * x + 2 * ab * x * y + 2 * ac * x * z + 2 * ad * x
+                 + b2 * y * y + 2 * bc * y * z + 2 * bd * y
+                 + c2 * z * z + 2 * cd * z
+                 + d2;
+        }
+    };
+
+    // Reduces the mesh to roughly `ratio` of its triangles. Vertices are welded by position first,
+    // so UV seams are merged (acceptable for distant LODs). The result is a non-indexed CPU mesh
+    // with smooth normals; call UploadMesh() before drawing it.
+    inline Mesh SimplifyMesh(const Mesh& mesh, float ratio) {
+        const int sourceTris = mesh.triangleCount;
+        const bool hasUV = mesh.texcoords != nullptr;
+
+        // Weld vertices that share a position
+        std::vector<Vector3> positions;
+        std::vector<Vector2> uvs;
+        std::unordered_map<uint64_t, std::vector<int>> buckets;
+        auto weld = [&](int src) {
+            Vector3 p = { mesh.vertices[src * 3], mesh.vertices[src * 3 + 1], mesh.vertices[src * 3 + 2] };
+            uint32_t bits[3];
+            std::memcpy(bits, &p, sizeof(bits));
+            uint64_t key = ((uint64_t)bits[0] * 73856093u) ^ ((uint64_t)bits[1] * 19349663u) ^ ((uint64_t)bits[2] * 83492791u);
+            auto& bucket = buckets[key];
+            for (int idx : bucket) {
+                if (positions[idx].x == p.x && positions[idx].y == p.y && positions[idx].z == p.z) return idx;
+            }
+            int idx = (int)positions.size();
+            positions.push_back(p);
+            uvs.push_back(hasUV ? Vector2{ mesh.texcoords[src * 2], mesh.texcoords[src * 2 + 1] } : Vector2{ 0, 0 });
+            bucket.push_back(idx);
+            return idx;
+        };
+
+        std::vector<std::array<int, 3>> tris;
+        tris.reserve(sourceTris);
+        for (int t = 0; t < sourceTris; t++) {
+            std::array<int, 3> tri;
+            for (int c = 0; c < 3; c++) {
+                int src = mesh.indices ? mesh.indices[t * 3 + c] : t * 3 + c;
+                tri[c] = weld(src);
+            }
+            if (tri[0] != tri[1] && tri[1] != tri[2] && tri[0] != tri[2]) tris.push_back(tri);
+        }
+
+        const size_t vertexCount = positions.size();
+        std::vector<Quadric> quadrics(vertexCount);
+        std::vector<std::vector<int>> adjacency(vertexCount);
+        std::unordered_map<uint64_t, int> edgeUse;
+        auto edgeKey = [](int a, int b) {
+            if (a > b) std::swap(a, b);
+            return ((uint64_t)(uint32_t)a << 32) | (uint32_t)b;
+        };
+
+        for (size_t t = 0; t < tris.size(); t++) {
+            const auto& tri = tris[t];
+            Vector3 n = Vector3CrossProduct(Vector3Subtract(positions[tri[1]], positions[tri[0]]),
+                                            Vector3Subtract(positions[tri[2]], positions[tri[0]]));
+            float area = Vector3Length(n);
+            if (area > 0.0f) n = Vector3Scale(n, 1.0f / area);
+            double d = -(double)Vector3DotProduct(n, positions[tri[0]]);
+            Quadric q = Quadric::FromPlane(n.x, n.y, n.z, d, area);
+            for (int c = 0; c < 3; c++) {
+                quadrics[tri[c]] += q;
+                adjacency[tri[c]].push_back((int)t);
+                edgeUse[edgeKey(tri[c], tri[(c + 1) % 3])]++;
+            }
+        }
+
+        // Open borders get a strong perpendicular plane so silhouettes don't erode
+        const double borderWeight = 1000.0;
+        for (const auto& tri : tris) {
+            Vector3 n = Vector3Normalize(Vector3CrossProduct(Vector3Subtract(positions[tri[1]], positions[tri[0]]),
+                                                             Vector3Subtract(positions[tri[2]], positions[tri[0]])));
+            for (int c = 0; c < 3; c++) {
+                int a = tri[c], b = tri[(c + 1) % 3];
+                if (edgeUse[edgeKey(a, b)] != 1) continue;
+                Vector3 edge = Vector3Subtract(positions[b], positions[a]);
+                Vector3 side = Vector3Normalize(Vector3CrossProduct(edge, n));
+                double d = -(double)Vector3DotProduct(side, positions[a]);
+                Quadric q = Quadric::FromPlane(side.x, side.y, side.z, d, borderWeight * Vector3LengthSqr(edge));
+                quadrics[a] += q;
+                quadrics[b] += q;
+            }
+        }
+
+        struct Candidate {
+            double cost;
+            int a, b;
+            int versionA, versionB;
+            Vector3 target;
+            int choice; // 0 = keep a, 1 = keep b, 2 = midpoint
+            bool operator>(const Candidate& o) const { return cost > o.cost; }
+        };
+
+        std::vector<int> version(vertexCount, 0);
+        std::vector<bool> removed(vertexCount, false);
+        std::vector<bool> aliveTri(tris.size(), true);
+        std::priority_queue<Candidate, std::vector<Candidate>, std::greater<Candidate>> heap;
+
+        auto pushEdge = [&](int a, int b) {
+            Quadric q = quadrics[a];
+            q += quadrics[b];
+            Vector3 options[3] = { positions[a], positions[b], Vector3Lerp(positions[a], positions[b], 0.5f) };
+            Candidate best = { q.Error(options[0]), a, b, version[a], version[b], options[0], 0 };
+            for (int i = 1; i < 3; i++) {
+                double err = q.Error(options[i]);
+                if (err < best.cost) { best.cost = err; best.target = options[i]; best.choice = i; }
+            }
+            heap.push(best);
+        };
+
+        for (const auto& tri : tris) {
+            for (int c = 0; c < 3; c++) {
+                int a = tri[c], b = tri[(c + 1) % 3];
+                if (a < b) pushEdge(a, b);
+                else if (edgeUse[edgeKey(a, b)] == 1) pushEdge(b, a);
+            }
+        }
+
+        // Moving `moved` to `target` must not flip any surviving triangle around it
+        auto flips = [&](int moved, int other, Vector3 target) {
+            for (int t : adjacency[moved]) {
+                if (!aliveTri[t]) continue;
+                const auto& tri = tris[t];
+                if (tri[0] == other || tri[1] == other || tri[2] == other) continue;
+                Vector3 p[3] = { positions[tri[0]], positions[tri[1]], positions[tri[2]] };
+                Vector3 before = Vector3CrossProduct(Vector3Subtract(p[1], p[0]), Vector3Subtract(p[2], p[0]));
+                for (int c = 0; c < 3; c++) if (tri[c] == moved) p[c] = target;
+                Vector3 after = Vector3CrossProduct(Vector3Subtract(p[1], p[0]), Vector3Subtract(p[2], p[0]));
+                if (Vector3DotProduct(before, after) <= 0.0f) return true;
+            }
+            return false;
+        };
+
+        size_t aliveCount = tris.size();
+        const size_t targetCount = (size_t)(ratio * (float)aliveCount);
+
+        while (aliveCount > targetCount && !heap.empty()) {
+            Candidate c = heap.top();
+            heap.pop();
+            if (removed[c.a] || removed[c.b]) continue;
+            if (version[c.a] != c.versionA || version[c.b] != c.versionB) continue;
+            if (flips(c.a, c.b, c.target) || flips(c.b, c.a, c.target)) continue;
+
+            int keep = c.a, gone = c.b;
+            positions[keep] = c.target;
+            if (c.choice == 1) uvs[keep] = uvs[gone];
+            else if (c.choice == 2) uvs[keep] = Vector2Lerp(uvs[keep], uvs[gone], 0.5f);
+            quadrics[keep] += quadrics[gone];
+            removed[gone] = true;
+            version[keep]++;
+
+            for (int t : adjacency[gone]) {
+                if (!aliveTri[t]) continue;
+                auto& tri = tris[t];
+                if (tri[0] == keep || tri[1] == keep || tri[2] == keep) {
+                    aliveTri[t] = false;
+                    aliveCount--;
+                    continue;
+                }
+                for (int k = 0; k < 3; k++) if (tri[k] == gone) tri[k] = keep;
+                adjacency[keep].push_back(t);
+            }
+            adjacency[gone].clear();
+
+            std::vector<int> compacted;
+            for (int t : adjacency[keep]) if (aliveTri[t]) compacted.push_back(t);
+            adjacency[keep].swap(compacted);
+
+            for (int t : adjacency[keep]) {
+                for (int k = 0; k < 3; k++) {
+                    int n = tris[t][k];
+                    if (n != keep) pushEdge(keep, n);
+                }
+            }
+        }
+
+        // Smooth normals over the welded topology
+        std::vector<Vector3> normals(vertexCount, Vector3{ 0, 0, 0 });
+        for (size_t t = 0; t < tris.size(); t++) {
+            if (!aliveTri[t]) continue;
+            const auto& tri = tris[t];
+            Vector3 n = Vector3CrossProduct(Vector3Subtract(positions[tri[1]], positions[tri[0]]),
+                                            Vector3Subtract(positions[tri[2]], positions[tri[0]]));
+            for (int c = 0; c < 3; c++) normals[tri[c]] = Vector3Add(normals[tri[c]], n);
+        }
+
+        Mesh result = { 0 };
+        result.triangleCount = (int)aliveCount;
+        result.vertexCount = (int)aliveCount * 3;
+        result.vertices = (float*)MemAlloc(result.vertexCount * 3 * sizeof(float));
+        result.normals = (float*)MemAlloc(result.vertexCount * 3 * sizeof(float));
+        if (hasUV) result.texcoords = (float*)MemAlloc(result.vertexCount * 2 * sizeof(float));
+
+        int v = 0;
+        for (size_t t = 0; t < tris.size(); t++) {
+            if (!aliveTri[t]) continue;
+            for (int c = 0; c < 3; c++, v++) {
+                int idx = tris[t][c];
+                Vector3 n = Vector3Normalize(normals[idx]);
+                result.vertices[v * 3] = positions[idx].x;
+                result.vertices[v * 3 + 1] = positions[idx].y;
+                result.vertices[v * 3 + 2] = positions[idx].z;
+                result.normals[v * 3] = n.x;
+                result.normals[v * 3 + 1] = n.y;
+                result.normals[v * 3 + 2] = n.z;
+                if (hasUV) {
+                    result.texcoords[v * 2] = uvs[idx].x;
+                    result.texcoords[v * 2 + 1] = uvs[idx].y;
+                }
+            }
+        }
+
+        return result;
+    }
+
+    // Builds a GPU-ready copy of the model with every mesh simplified to `ratio`.
+    // Materials are copied (shader and textures stay shared with the source model).
+    inline Model GenerateLODModel(const Model& model, float ratio) {
+        Model lod = model;
+        lod.meshes = (Mesh*)MemAlloc(model.meshCount * sizeof(Mesh));
+        lod.meshMaterial = (int*)MemAlloc(model.meshCount * sizeof(int));
+        lod.materials = (Material*)MemAlloc(model.materialCount * sizeof(Material));
+        lod.boneCount = 0;
+        lod.bones = nullptr;
+        lod.bindPose = nullptr;
+
+        for (int i = 0; i < model.meshCount; i++) {
+            lod.meshes[i] = SimplifyMesh(model.meshes[i], ratio);
+            UploadMesh(&lod.meshes[i], false);
+            lod.meshMaterial[i] = model.meshMaterial[i];
+        }
+
+        for (int i = 0; i < model.materialCount; i++) {
+            lod.materials[i] = model.materials[i];
+            lod.materials[i].maps = (MaterialMap*)MemAlloc(MAX_MATERIAL_MAPS * sizeof(MaterialMap));
+            std::memcpy(lod.materials[i].maps, model.materials[i].maps, MAX_MATERIAL_MAPS * sizeof(MaterialMap));
+        }
+
+        return lod;
+    }
+}
+
+#endif
@@ -0,0 +1,357 @@
+/*
+ * Copyright (C) 2026 Artem Svitlov (Moscow, Russia)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// Engine-level draw command list. Components record packets instead of calling raylib directly,
+// the list is replayed later on the thread that owns the GL context.
+
+#ifndef RENDER_QUEUE_H
+#define RENDER_QUEUE_H
+
+#include "raylib.h"
+#include "rlgl.h"
+#include <vector>
+#include <string>
+#include <cstdint>
+#include <functional>
+#include <algorithm>
+#include <cstring>
+#include <cmath>
+#include "core/JobSystem.h"
+#include "core/CommandQueue.h"
+
+enum class DrawCommand : uint8_t {
+    Model,
+    Cube,
+    CubeWires,
+    Sphere,
+    SphereWires,
+    Grid,
+    Text,
+    Rectangle,
+    RectangleLines,
+    Circle,
+    CircleLines,
+    Line,
+    Pixel,
+    Texture,
+    TexturePro,
+    CircleBatch,        // count * (x, y, radius [, packed color]) floats
+    RectangleBatch,     // count * (x, y, width, height [, packed color]) floats
+    SpriteBatch,        // count * (x, y, rotation, scale [, packed color]) floats, centered on x/y
+    Custom      // Calls callback(object) at replay time
+};
+
+struct DrawPacket {
+    uint64_t sortKey = 0;               // Stamped by the queue, submission order is ascending
+    DrawCommand command = DrawCommand::Custom;
+    Color color = WHITE;
+    Vector3 position = { 0, 0, 0 };     // 2D commands use x/y
+    Vector3 size = { 0, 0, 0 };         // Extents / scale, radius in x, line end point in x/y
+    Vector3 rotationAxis = { 0, 1, 0 };
+    float rotation = 0.0f;
+    Vector2 origin = { 0, 0 };
+    Rectangle source = { 0, 0, 0, 0 };
+    Rectangle dest = { 0, 0, 0, 0 };
+    Texture2D texture = { 0 };
+    const Model* model = nullptr;
+    Material material = {};             // Override for materials[0] when hasMaterial is set
+    bool hasMaterial = false;
+    void (*callback)(const void* object) = nullptr;
+    const void* object = nullptr;
+    size_t text = 0;                    // Offset into the queue text storage
+    size_t data = 0;                    // Offset into the queue float storage (batches)
+    uint32_t count = 0;                 // Batch instance count
+    bool instanceColors = false;        // Batch carries one packed color per instance
+};
+
+namespace MoonRay {
+    // Batches keep per-instance colors in a float slot, bit for bit
+    inline float PackColor(Color c) {
+        uint32_t bits = ((uint32_t)c.r << 24) | ((uint32_t)c.g << 16) | ((uint32_t)c.b << 8) | c.a;
+        float f;
+        std::memcpy(&f, &bits, sizeof(f));
+        return f;
+    }
+
+    inline Color UnpackColor(float f) {
+        uint32_t bits;
+        std::memcpy(&bits, &f, sizeof(bits));
+        return { (unsigned char)(bits >> 24), (unsigned char)(bits >> 16), (unsigned char)(bits >> 8), (unsigned char)bits };
+    }
+
+    // Floats per batch instance, not counting the color slot
+    inline int BatchStride(DrawCommand command) {
+        return command == DrawCommand::CircleBatch ? 3 : 4;
+    }
+}
+
+class RenderQueue {
+private:
+    std::vector<DrawPacket> packets;
+    std::string text;
+    std::vector<float> data;
+    uint64_t sortKey = 0;
+
+    static bool KeyLess(const DrawPacket& a, const DrawPacket& b) { return a.sortKey < b.sortKey; }
+
+#ifndef MOONRAY_HEADLESS
+    // One rlBegin/rlEnd for the whole batch, rlgl flushes by itself when its buffer fills up.
+    // Vertex order follows raylib's DrawCircleSector/DrawRectanglePro/DrawTexturePro.
+    static void ExecuteBatch(const DrawPacket& p, const float* values) {
+        const int stride = MoonRay::BatchStride(p.command) + (p.instanceColors ? 1 : 0);
+        const float* v = values;
+
+        switch (p.command) {
+            case DrawCommand::CircleBatch: {
+                const int segments = 36;
+                struct UnitCircle { float xy[segments + 1][2]; };
+                static const UnitCircle circle = [] {
+                    UnitCircle c;
+                    for (int i = 0; i <= segments; i++) {
+                        c.xy[i][0] = cosf(2.0f * PI * i / segments);
+                        c.xy[i][1] = sinf(2.0f * PI * i / segments);
+                    }
+                    return c;
+                }();
+                const auto& unit = circle.xy;
+
+                rlBegin(RL_TRIANGLES);
+                for (uint32_t n = 0; n < p.count; n++, v += stride) {
+                    Color c = p.instanceColors ? MoonRay::UnpackColor(v[3]) : p.color;
+                    rlColor4ub(c.r, c.g, c.b, c.a);
+                    for (int i = 0; i < segments; i++) {
+                        rlVertex2f(v[0], v[1]);
+                        rlVertex2f(v[0] + unit[i + 1][0] * v[2], v[1] + unit[i + 1][1] * v[2]);
+                        rlVertex2f(v[0] + unit[i][0] * v[2], v[1] + unit[i][1] * v[2]);
+                    }
+                }
+                rlEnd();
+                break;
+            }
+            case DrawCommand::RectangleBatch: {
+                rlBegin(RL_TRIANGLES);
+                for (uint32_t n = 0; n < p.count; n++, v += stride) {
+                    Color c = p.instanceColors ? MoonRay::UnpackColor(v[4]) : p.color;
+                    float x0 = v[0], y0 = v[1], x1 = v[0] + v[2], y1 = v[1] + v[3];
+                    rlColor4ub(c.r, c.g, c.b, c.a);
+                    rlVertex2f(x0, y0);
+                    rlVertex2f(x0, y1);
+                    rlVertex2f(x1, y0);
+                    rlVertex2f(x1, y0);
+                    rlVertex2f(x0, y1);
+                    rlVertex2f(x1, y1);
+                }
+                rlEnd();
+                break;
+            }
+            case DrawCommand::SpriteBatch: {
+                if (p.texture.id == 0) break;
+                rlSetTexture(p.texture.id);
+                rlBegin(RL_QUADS);
+                rlNormal3f(0.0f, 0.0f, 1.0f);
+                for (uint32_t n = 0; n < p.count; n++, v += stride) {
+                    Color c = p.instanceColors ? MoonRay::UnpackColor(v[4]) : p.color;
+                    float w = p.texture.width * v[3], h = p.texture.height * v[3];
+                    float s = sinf(v[2] * DEG2RAD), co = cosf(v[2] * DEG2RAD);
+                    float dx = -w * 0.5f, dy = -h * 0.5f;
+
+                    rlColor4ub(c.r, c.g, c.b, c.a);
+                    rlTexCoord2f(0.0f, 0.0f);
+                    rlVertex2f(v[0] + dx * co - dy * s, v[1] + dx * s + dy * co);
+                    rlTexCoord2f(0.0f, 1.0f);
+                    rlVertex2f(v[0] + dx * co - (dy + h) * s, v[1] + dx * s + (dy + h) * co);
+                    rlTexCoord2f(1.0f, 1.0f);
+                    rlVertex2f(v[0] + (dx + w) * co - (dy + h) * s, v[1] + (dx + w) * s + (dy + h) * co);
+                    rlTexCoord2f(1.0f, 0.0f);
+                    rlVertex2f(v[0] + (dx + w) * co - dy * s, v[1] + (dx + w) * s + dy * co);
+                }
+                rlEnd();
+                rlSetTexture(0);
+                break;
+            }
+            default: break;
+        }
+    }
+#endif
+
+public:
+    void Clear() {
+        packets.clear();
+        text.clear();
+        data.clear();
+        sortKey = 0;
+    }
+
+    // Key given to every packet pushed from now on (e.g. the zIndex of the object being recorded)
+    void SetSortKey(uint64_t key) { sortKey = key; }
+
+    // values/valueCount: float payload of batch commands, copied into the queue
+    void Push(const DrawPacket& packet, const char* str = nullptr, const float* values = nullptr, size_t valueCount = 0) {
+        packets.push_back(packet);
+        packets.back().sortKey = sortKey;
+        if (str) {
+            packets.back().text = text.size();
+            text.append(str);
+            text.push_back('\0');
+        }
+        if (values) {
+            packets.back().data = data.size();
+            data.insert(data.end(), values, values + valueCount);
+        }
+    }
+
+    size_t Size() const { return packets.size(); }
+    bool Empty() const { return packets.empty(); }
+
+    static void Execute(const DrawPacket& p, const char* str, const float* values = nullptr) {
+#ifdef MOONRAY_HEADLESS
+        // No GL in the server build, rendering components and Lua draw calls do nothing
+        (void)p; (void)str; (void)values;
+#else
+        switch (p.command) {
+            case DrawCommand::Model: {
+                Model model = *p.model;
+                if (p.hasMaterial) model.materials[0] = p.material;
+                DrawModelEx(model, p.position, p.rotationAxis, p.rotation, p.size, p.color);
+                break;
+            }
+            case DrawCommand::Cube: DrawCube(p.position, p.size.x, p.size.y, p.size.z, p.color); break;
+            case DrawCommand::CubeWires: DrawCubeWires(p.position, p.size.x, p.size.y, p.size.z, p.color); break;
+            case DrawCommand::Sphere: DrawSphere(p.position, p.size.x, p.color); break;
+            case DrawCommand::SphereWires: DrawSphereWires(p.position, p.size.x, (int)p.size.y, (int)p.size.z, p.color); break;
+            case DrawCommand::Grid: DrawGrid((int)p.size.x, p.size.y); break;
+            case DrawCommand::Text: DrawText(str, (int)p.position.x, (int)p.position.y, (int)p.size.x, p.color); break;
+            case DrawCommand::Rectangle: DrawRectangle((int)p.position.x, (int)p.position.y, (int)p.size.x, (int)p.size.y, p.color); break;
+            case DrawCommand::RectangleLines: DrawRectangleLines((int)p.position.x, (int)p.position.y, (int)p.size.x, (int)p.size.y, p.color); break;
+            case DrawCommand::Circle: DrawCircle((int)p.position.x, (int)p.position.y, p.size.x, p.color); break;
+            case DrawCommand::CircleLines: DrawCircleLines((int)p.position.x, (int)p.position.y, p.size.x, p.color); break;
+            case DrawCommand::Line: DrawLine((int)p.position.x, (int)p.position.y, (int)p.size.x, (int)p.size.y, p.color); break;
+            case DrawCommand::Pixel: DrawPixel((int)p.position.x, (int)p.position.y, p.color); break;
+            case DrawCommand::Texture: DrawTexture(p.texture, (int)p.position.x, (int)p.position.y, p.color); break;
+            case DrawCommand::TexturePro: DrawTexturePro(p.texture, p.source, p.dest, p.origin, p.rotation, p.color); break;
+            case DrawCommand::CircleBatch:
+            case DrawCommand::RectangleBatch:
+            case DrawCommand::SpriteBatch: if (values) ExecuteBatch(p, values); break;
+            case DrawCommand::Custom: if (p.callback) p.callback(p.object); break;
+        }
+#endif
+    }
+
+    void Sort() {
+        std::stable_sort(packets.begin(), packets.end(), KeyLess);
+    }
+
+    // Stable-sorts every part on the workers and merges them pairwise into `out`.
+    // Equal keys keep part order, so parts recorded from consecutive object ranges
+    // come out exactly in scene order.
+    static void Merge(std::vector<RenderQueue>& parts, RenderQueue& out, JobSystem& jobs) {
+        out.Clear();
+        if (parts.empty()) return;
+
+        std::vector<size_t> textBase(parts.size());
+        std::vector<size_t> dataBase(parts.size());
+        for (size_t i = 0; i < parts.size(); i++) {
+            textBase[i] = out.text.size();
+            out.text += parts[i].text;
+            dataBase[i] = out.data.size();
+            out.data.insert(out.data.end(), parts[i].data.begin(), parts[i].data.end());
+        }
+
+        jobs.ParallelFor(parts.size(), [&](size_t i) {
+            for (auto& p : parts[i].packets) {
+                p.text += textBase[i];
+                p.data += dataBase[i];
+            }
+            std::stable_sort(parts[i].packets.begin(), parts[i].packets.end(), KeyLess);
+        });
+
+        std::vector<std::vector<DrawPacket>> runs(parts.size());
+        for (size_t i = 0; i < parts.size(); i++) runs[i].swap(parts[i].packets);
+
+        while (runs.size() > 1) {
+            std::vector<std::vector<DrawPacket>> merged((runs.size() + 1) / 2);
+            jobs.ParallelFor(merged.size(), [&](size_t i) {
+                size_t a = i * 2, b = i * 2 + 1;
+                if (b >= runs.size()) {
+                    merged[i].swap(runs[a]);
+                    return;
+                }
+                merged[i].resize(runs[a].size() + runs[b].size());
+                std::merge(runs[a].begin(), runs[a].end(), runs[b].begin(), runs[b].end(), merged[i].begin(), KeyLess);
+            });
+            runs.swap(merged);
+        }
+
+        out.packets.swap(runs[0]);
+    }
+
+    void Submit() const {
+        for (const auto& p : packets) Execute(p, text.c_str() + p.text, p.count ? data.data() + p.data : nullptr);
+    }
+
+    // Queue that draw calls made on this thread are recorded into (nullptr = draw immediately)
+    static RenderQueue*& Recording() {
+        static thread_local RenderQueue* current = nullptr;
+        return current;
+    }
+};
+
+class RecordingScope {
+private:
+    RenderQueue* previous;
+
+public:
+    explicit RecordingScope(RenderQueue& queue) : previous(RenderQueue::Recording()) {
+        RenderQueue::Recording() = &queue;
+    }
+    ~RecordingScope() { RenderQueue::Recording() = previous; }
+};
+
+namespace MoonRay {
+    // Records the packet if a queue is bound on this thread, otherwise draws it right away.
+    // A parallel update (isolated script OnUpdate) has neither, the draw is replayed on the main
+    // thread with the other deferred engine calls.
+    inline void SubmitDraw(const DrawPacket& packet, const char* text = nullptr, const float* values = nullptr, size_t valueCount = 0) {
+        if (RenderQueue* queue = RenderQueue::Recording()) {
+            queue->Push(packet, text, values, valueCount);
+        } else if (OnWorkerThread()) {
+            bool hasText = text != nullptr, hasValues = values != nullptr;
+            std::string str = hasText ? text : "";
+            std::vector<float> payload;
+            if (values) payload.assign(values, values + valueCount);
+            RunOnMainThread([=] {
+                SubmitDraw(packet, hasText ? str.c_str() : nullptr, hasValues ? payload.data() : nullptr, payload.size());
+            });
+        } else {
+            RenderQueue::Execute(packet, text, values);
+        }
+    }
+
+    // Installed by RenderThread while it owns the GL context
+    inline std::function<void(const std::function<void()>&)>& RenderThreadInvoker() {
+        static std::function<void(const std::function<void()>&)> invoker;
+        return invoker;
+    }
+
+    // GL resources (textures, meshes) must be created on the thread that owns the context
+    inline void RunOnRenderThread(const std::function<void()>& task) {
+        if (RenderThreadInvoker()) RenderThreadInvoker()(task);
+        else task();
+    }
+}
+
+#endif
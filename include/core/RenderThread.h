@@ -0,0 +1,90 @@
+/*
+ * Copyright (C) 2026 Artem Svitlov (Moscow, Russia)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// Dedicated render thread. It creates the window (and so owns the GL context), then replays
+// the RenderFrame recorded by the calling thread through a FramePipeline: while frame N is
+// replayed, the simulation updates and records frame N+1.
+
+#ifndef RENDER_THREAD_H
+#define RENDER_THREAD_H
+
+#include "raylib.h"
+#include "Imgui/rlImGui.h"
+#include "core/FramePipeline.h"
+#include <thread>
+#include <atomic>
+#include <string>
+#include <functional>
+
+class RenderThread {
+private:
+    FramePipeline pipeline;
+    std::thread thread;
+    std::atomic<bool> closeRequested{ false };
+
+    int width;
+    int height;
+    std::string title;
+    int targetFps;
+    std::function<void()> gui;
+
+    void Main() {
+        InitWindow(width, height, title.c_str());
+        SetTargetFPS(targetFps);
+        rlImGuiSetup(true);
+        pipeline.BindConsumer();
+
+        while (const RenderFrame* frame = pipeline.AcquireFrame()) {
+            ReplayFrame(*frame, gui);
+            pipeline.WaitForNextFrame();
+            EndDrawing();
+            closeRequested = WindowShouldClose();
+            pipeline.FramePresented();
+        }
+
+        rlImGuiShutdown();
+        CloseWindow();
+    }
+
+public:
+    // gui is called on the render thread inside every ImGui frame
+    RenderThread(int w, int h, const char* windowTitle, int fps, std::function<void()> guiCallback = nullptr)
+        : width(w), height(h), title(windowTitle), targetFps(fps), gui(std::move(guiCallback)) {
+        thread = std::thread([this] { Main(); });
+        pipeline.WaitForConsumer();
+    }
+
+    ~RenderThread() {
+        pipeline.Stop();
+        if (thread.joinable()) thread.join();
+    }
+
+    RenderThread(const RenderThread&) = delete;
+    RenderThread& operator=(const RenderThread&) = delete;
+
+    bool ShouldClose() const { return closeRequested; }
+
+    // Returns the frame to record into. Blocks until the frame before the one being
+    // replayed has been presented, i.e. the pipeline is at most one frame deep.
+    RenderFrame& BeginFrame() { return *pipeline.BeginFrame(); }
+    void EndFrame() { pipeline.EndFrame(); }
+
+    // Runs a task on the render thread (GL resource creation etc.) and waits for it
+    void Invoke(const std::function<void()>& task) { pipeline.Invoke(task); }
+};
+
+#endif
@@ -23,43 +23,270 @@
 #include <vector>
 #include <memory>
 #include <algorithm>
+#include <cstdint>
 #include "GameObject.h"
+#include "core/RenderQueue.h"
+#include "core/JobSystem.h"
+#include "core/CommandQueue.h"
+#include "core/AssetCache.h"
+#include "raylib.h"
 #include "components/Transform2D.h"
+#include "components/TransformComponent.h"
+#include "MoonRay/ScriptVM.h"
 
 class Scene {
 private:
+    MoonRay::ScriptVM scripts;      // Declared first: outlives the script components that use it
+    std::vector<MoonRay::ScriptVM*> isolatedVMs;    // Own VMs of isolated script components
+    std::vector<MoonRay::ScriptMessage> messages;
     std::vector<std::unique_ptr<GameObject>> gameObjects;
+    Camera3D camera = {};
+    float interpolationAlpha = 1.0f;
+    JobSystem* jobs = nullptr;
+    mutable RenderQueue immediateQueue;
+    mutable std::vector<RenderQueue> recordParts;
+    mutable std::vector<GameObject*> visible;
+    std::vector<GameObject*> parallelUpdates;
+    std::vector<CommandQueue> commandQueues;    // One per parallel object, applied in order
+    std::vector<float*> systemFields;           // Per matched object, the floats of each query entry
+    std::vector<std::vector<float>> systemData; // Packed batch per query entry
+
+    static constexpr size_t ObjectsPerChunk = 256;
+
+    using SystemComponent = MoonRay::ScriptSystems::ComponentType;
+
+    // Floats of a component Lua systems can query, nullptr if the object doesn't have it
+    static float* SystemFloats(GameObject& obj, SystemComponent type) {
+        switch (type) {
+            case SystemComponent::Transform:
+                if (auto* transform = obj.GetComponent<TransformComponent>()) return transform->Data();
+                break;
+            case SystemComponent::Transform2D:
+                if (auto* transform = obj.GetComponent<Transform2DComponent>()) return transform->Data();
+                break;
+            default: break;
+        }
+        return nullptr;
+    }
+
+    static size_t SystemFloatCount(SystemComponent type) {
+        return type == SystemComponent::Transform ? TransformComponent::FloatCount : Transform2DComponent::FloatCount;
+    }
+
+    // Calls each of the VM's systems once per BatchSize matching objects. The components are
+    // copied into packed buffers and back, so the script reads plain FloatArrays.
+    void RunSystems(MoonRay::ScriptVM& vm, float deltaTime) {
+        if (vm.SystemCount() == 0) return;
+        vm.CompactSystems();
+
+        size_t systems = vm.SystemCount();     // Systems registered while running start next frame
+        for (size_t s = 0; s < systems; s++) {
+            if (vm.System(s).removed) continue;
+            const std::vector<SystemComponent> query = vm.System(s).query;
+            size_t width = query.size();
+
+            systemFields.clear();
+            for (auto& obj : gameObjects) {
+                size_t start = systemFields.size();
+                for (SystemComponent type : query) {
+                    float* fields = SystemFloats(*obj, type);
+                    if (!fields) break;
+                    systemFields.push_back(fields);
+                }
+                if (systemFields.size() - start != width) systemFields.resize(start);
+            }
+
+            size_t matched = systemFields.size() / width;
+            if (systemData.size() < width) systemData.resize(width);
+            float* data[SystemComponent::ComponentTypeCount];
+            size_t floats[SystemComponent::ComponentTypeCount];
+            for (size_t k = 0; k < width; k++) floats[k] = SystemFloatCount(query[k]);
+
+            for (size_t first = 0; first < matched; first += MoonRay::ScriptSystems::BatchSize) {
+                size_t count = std::min(MoonRay::ScriptSystems::BatchSize, matched - first);
+                for (size_t k = 0; k < width; k++) {
+                    systemData[k].resize(count * floats[k]);
+                    data[k] = systemData[k].data();
+                    for (size_t i = 0; i < count; i++) {
+                        std::copy_n(systemFields[(first + i) * width + k], floats[k], data[k] + i * floats[k]);
+                    }
+                }
+
+                bool ok = vm.RunSystem(s, deltaTime, count, data, floats);
+
+                for (size_t k = 0; k < width; k++) {
+                    for (size_t i = 0; i < count; i++) {
+                        std::copy_n(data[k] + i * floats[k], floats[k], systemFields[(first + i) * width + k]);
+                    }
+                }
+                if (!ok) break;     // One error report per frame, not per batch
+            }
+        }
+    }
+
+    static uint64_t LayerKey(int zIndex) { return (uint64_t)((int64_t)zIndex - INT32_MIN); }
+
+    // Split recordings key packets by layer (zIndex, 32 bits), object index (24 bits) and
+    // component index (8 bits), so the merge reproduces the serial recording exactly
+    static uint64_t SplitKey(uint64_t layer, size_t object) {
+        return layer << 32 | (uint64_t)std::min<size_t>(object, 0xFFFFFF) << 8;
+    }
+
+    // 2D packets are keyed by zIndex; 3D packets all share key 0 and keep scene order
+    void RecordObjects(RenderQueue& queue, bool overlay) const {
+        visible.clear();
+        for (const auto& obj : gameObjects) {
+            if (!overlay || obj->GetComponent<Transform2DComponent>()) visible.push_back(obj.get());
+        }
+
+        auto keyOf = [overlay](GameObject* obj) -> uint64_t {
+            return overlay ? LayerKey(obj->GetComponent<Transform2DComponent>()->zIndex) : 0;
+        };
+
+        queue.Clear();
+        if (!jobs || visible.size() <= ObjectsPerChunk) {
+            RecordingScope scope(queue);
+            for (auto* obj : visible) {
+                queue.SetSortKey(keyOf(obj));
+                obj->Record(queue);
+            }
+            if (overlay) queue.Sort();
+            return;
+        }
+
+        // Each chunk of consecutive objects fills its own list, no locking needed
+        size_t chunks = (visible.size() + ObjectsPerChunk - 1) / ObjectsPerChunk;
+        recordParts.resize(chunks + 1);
+        for (auto& part : recordParts) part.Clear();
+
+        jobs->ParallelFor(chunks, [&](size_t chunk) {
+            RenderQueue& part = recordParts[chunk];
+            RecordingScope scope(part);
+            size_t end = std::min(visible.size(), (chunk + 1) * ObjectsPerChunk);
+            for (size_t i = chunk * ObjectsPerChunk; i < end; i++) {
+                visible[i]->Record(part, RecordFilter::Parallel, SplitKey(keyOf(visible[i]), i));
+            }
+        });
+
+        RenderQueue& serial = recordParts.back();
+        {
+            RecordingScope scope(serial);
+            for (size_t i = 0; i < visible.size(); i++) {
+                if (!visible[i]->HasSerialRecord()) continue;
+                visible[i]->Record(serial, RecordFilter::Serial, SplitKey(keyOf(visible[i]), i));
+            }
+        }
+
+        RenderQueue::Merge(recordParts, queue, *jobs);
+    }
 
 public:
     Scene() = default;
 
     void AddGameObject(std::unique_ptr<GameObject> obj) {
-        if (obj) gameObjects.push_back(std::move(obj));
+        if (!obj) return;
+        obj->SetScene(this);
+        gameObjects.push_back(std::move(obj));
     }
 
-    void Update(float deltaTime) {
-        for (auto& obj : gameObjects) obj->Update(deltaTime);
+    // Lua VM shared by every script in this scene
+    MoonRay::ScriptVM& GetScriptVM() { return scripts; }
+
+    // Camera used by components that depend on the view (LOD selection etc.)
+    void SetCamera(const Camera3D& cam) { camera = cam; }
+    const Camera3D& GetCamera() const { return camera; }
+
+    // Isolated script components register their own VM, so it gets the scene's messages
+    void AddIsolatedVM(MoonRay::ScriptVM* vm) { isolatedVMs.push_back(vm); }
+    void RemoveIsolatedVM(MoonRay::ScriptVM* vm) {
+        isolatedVMs.erase(std::remove(isolatedVMs.begin(), isolatedVMs.end(), vm), isolatedVMs.end());
     }
 
-    void Render() const {
-        for (const auto& obj : gameObjects) obj->Render();
+    // Hands the messages broadcast last frame to every VM of the scene
+    void DeliverMessages() {
+        messages.clear();
+        scripts.TakeMessages(messages);
+        for (auto* vm : isolatedVMs) vm->TakeMessages(messages);
+        if (messages.empty()) return;
+
+        scripts.Deliver(messages);
+        for (auto* vm : isolatedVMs) vm->Deliver(messages);
     }
 
-    void Render2D() {
-        std::vector<GameObject*> sorted2D;
+    // Components that update in parallel (isolated scripts) run first, spread over the job
+    // system, then everything else in scene order. Main-thread calls the parallel ones make
+    // are applied in between. Lua systems run last.
+    void Update(float deltaTime) {
+        DeliverMessages();
+        scripts.ApplyReloads();
+        scripts.RunCoroutines(deltaTime);
 
-        for (auto& obj : gameObjects) {
-            if (obj->GetComponent<Transform2DComponent>()) {
-                sorted2D.push_back(obj.get());
+        parallelUpdates.clear();
+        if (jobs) {
+            for (auto& obj : gameObjects) {
+                if (obj->HasParallelUpdate()) parallelUpdates.push_back(obj.get());
             }
         }
+        if (parallelUpdates.empty()) {
+            for (auto& obj : gameObjects) obj->Update(deltaTime);
+        } else {
+            if (commandQueues.size() < parallelUpdates.size()) commandQueues.resize(parallelUpdates.size());
+            jobs->ParallelFor(parallelUpdates.size(), [&](size_t i) {
+                CommandScope scope(commandQueues[i]);
+                parallelUpdates[i]->Update(deltaTime, UpdateFilter::Parallel);
+            });
+            for (size_t i = 0; i < parallelUpdates.size(); i++) commandQueues[i].Apply();
 
-        std::sort(sorted2D.begin(), sorted2D.end(), [](GameObject* a, GameObject* b) {
-            return a->GetComponent<Transform2DComponent>()->zIndex <
-                   b->GetComponent<Transform2DComponent>()->zIndex;
-        });
+            for (auto& obj : gameObjects) obj->Update(deltaTime, UpdateFilter::Serial);
+        }
+
+        RunSystems(scripts, deltaTime);
+        for (auto* vm : isolatedVMs) RunSystems(*vm, deltaTime);
+    }
+
+    // Spends the script VMs' GC budget (ScriptVM::StepGC) and unloads textures nobody uses
+    // anymore (AssetCache). Call once per frame after recording, on the thread that updates the scene.
+    void CollectGarbage() {
+        AssetCache::Get().Collect();
+        scripts.StepGC();
+        if (jobs) jobs->ParallelFor(isolatedVMs.size(), [&](size_t i) { isolatedVMs[i]->StepGC(); });
+        else for (auto* vm : isolatedVMs) vm->StepGC();
+    }
+
+    // One fixed simulation tick: remember the previous state, then update
+    void FixedUpdate(float step) {
+        for (auto& obj : gameObjects) obj->StorePreviousState();
+        Update(step);
+    }
+
+    // Blend factor between the previous and current tick used when recording (1 = current state)
+    void SetInterpolationAlpha(float alpha) { interpolationAlpha = alpha; }
+    float GetInterpolationAlpha() const { return interpolationAlpha; }
+
+    // Recording is spread over the job system when one is set (nullptr = record serially)
+    void SetJobSystem(JobSystem* jobSystem) { jobs = jobSystem; }
+
+    // Replaces the queue contents with the draw packets of the 3D pass. Draw calls made through
+    // MoonRay::SubmitDraw (Lua bindings) during recording land in the same queue.
+    void Record(RenderQueue& queue) const {
+        RecordObjects(queue, false);
+    }
+
+    // 2D pass: objects with a Transform2DComponent, ordered by zIndex
+    void Record2D(RenderQueue& queue) const {
+        RecordObjects(queue, true);
+    }
+
+    void Render() const {
+        immediateQueue.Clear();
+        Record(immediateQueue);
+        immediateQueue.Submit();
+    }
 
-        for (auto* obj : sorted2D) obj->Render();
+    void Render2D() const {
+        immediateQueue.Clear();
+        Record2D(immediateQueue);
+        immediateQueue.Submit();
     }
 };
 
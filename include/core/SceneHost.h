@@ -0,0 +1,251 @@
+/*
+ * Copyright (C) 2026 Artem Svitlov (Moscow, Russia)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// Runs many independent scenes (e.g. server match rooms) on a set of shard threads, one per core.
+// Every scene lives on exactly one shard and is only touched by that thread, so scenes share no
+// mutable state. That includes their Lua VMs, which are created with the scene and destroyed on
+// the shard thread. Each shard ticks its scenes on its own fixed clock and records per-scene
+// tick cost.
+
+#ifndef SCENE_HOST_H
+#define SCENE_HOST_H
+
+#include <vector>
+#include <memory>
+#include <thread>
+#include <mutex>
+#include <atomic>
+#include <chrono>
+#include <algorithm>
+#include <cstdint>
+#include "core/Scene.h"
+
+#if defined(__linux__)
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+struct SceneStats {
+    size_t id = 0;
+    size_t shard = 0;
+    uint64_t ticks = 0;
+    double lastTickMs = 0.0;
+    double avgTickMs = 0.0;     // Exponential moving average
+    double maxTickMs = 0.0;
+    double totalMs = 0.0;
+};
+
+class SceneHost {
+private:
+    struct Entry {
+        std::unique_ptr<Scene> scene;
+        SceneStats stats;
+    };
+
+    struct Shard {
+        std::thread thread;
+        std::mutex mutex;                               // Guards pending, removed and published
+        std::vector<std::unique_ptr<Entry>> pending;    // Added since the last tick
+        std::vector<size_t> removed;
+        std::vector<SceneStats> published;              // Stats snapshot after the last tick
+        std::vector<std::unique_ptr<Entry>> scenes;     // Shard thread only
+        size_t load = 0;                                // Scenes placed here (host mutex)
+    };
+
+    std::vector<std::unique_ptr<Shard>> shards;
+    std::mutex mutex;                   // Guards placement, shard load and started
+    std::vector<size_t> placement;      // Shard of every scene id
+    bool started = false;
+
+    static constexpr size_t Removed = SIZE_MAX;
+
+    float step;
+    bool unlocked = false;
+    uint64_t tickLimit = 0;
+    std::atomic<bool> stopping{ false };
+    std::atomic<size_t> finishedShards{ 0 };
+
+    static constexpr double CostSmoothing = 0.05;   // EMA weight of the newest tick
+
+    static void PinToCore(size_t core) {
+#if defined(__linux__)
+        unsigned cores = std::thread::hardware_concurrency();
+        if (cores == 0) return;
+        cpu_set_t set;
+        CPU_ZERO(&set);
+        CPU_SET(core % cores, &set);
+        pthread_setaffinity_np(pthread_self(), sizeof(set), &set);
+#else
+        (void)core;     // Left to the OS scheduler elsewhere
+#endif
+    }
+
+    // Moves scenes added or removed since the last tick in or out of the shard
+    static void Sync(Shard& shard) {
+        std::vector<std::unique_ptr<Entry>> dropped;
+        {
+            std::lock_guard<std::mutex> lock(shard.mutex);
+            for (auto& entry : shard.pending) shard.scenes.push_back(std::move(entry));
+            shard.pending.clear();
+
+            for (size_t id : shard.removed) {
+                auto it = std::find_if(shard.scenes.begin(), shard.scenes.end(),
+                    [id](const std::unique_ptr<Entry>& e) { return e->stats.id == id; });
+                if (it == shard.scenes.end()) continue;
+                dropped.push_back(std::move(*it));
+                shard.scenes.erase(it);
+            }
+            shard.removed.clear();
+        }
+        // Destroyed outside the lock, still on the shard thread
+    }
+
+    void ShardMain(Shard& shard, size_t index) {
+        PinToCore(index);
+
+        using Clock = std::chrono::steady_clock;
+        const auto interval = std::chrono::duration_cast<Clock::duration>(std::chrono::duration<double>(step));
+        auto next = Clock::now();
+
+        for (uint64_t tick = 0; !stopping && (tickLimit == 0 || tick < tickLimit); tick++) {
+            Sync(shard);
+
+            for (auto& entry : shard.scenes) {
+                auto start = Clock::now();
+                entry->scene->FixedUpdate(step);
+                double ms = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+                SceneStats& stats = entry->stats;
+                stats.avgTickMs = stats.ticks == 0 ? ms : stats.avgTickMs + (ms - stats.avgTickMs) * CostSmoothing;
+                stats.lastTickMs = ms;
+                stats.maxTickMs = std::max(stats.maxTickMs, ms);
+                stats.totalMs += ms;
+                stats.ticks++;
+            }
+
+            for (auto& entry : shard.scenes) entry->scene->CollectGarbage();
+
+            {
+                std::lock_guard<std::mutex> lock(shard.mutex);
+                shard.published.clear();
+                for (const auto& entry : shard.scenes) shard.published.push_back(entry->stats);
+            }
+
+            if (!unlocked) {
+                next += interval;
+                auto now = Clock::now();
+                if (next < now) next = now;     // Overran, don't burst to catch up
+                std::this_thread::sleep_until(next);
+            }
+        }
+
+        // Scenes (and their Lua VMs) are destroyed on the thread that ran them
+        shard.scenes.clear();
+        finishedShards++;
+    }
+
+public:
+    // threadCount 0 = one shard per hardware thread
+    explicit SceneHost(size_t threadCount = 0, int ticksPerSecond = 60)
+        : step(1.0f / (ticksPerSecond > 0 ? ticksPerSecond : 60)) {
+        if (threadCount == 0) threadCount = std::max(1u, std::thread::hardware_concurrency());
+        for (size_t i = 0; i < threadCount; i++) shards.push_back(std::make_unique<Shard>());
+    }
+
+    ~SceneHost() { Stop(); }
+
+    SceneHost(const SceneHost&) = delete;
+    SceneHost& operator=(const SceneHost&) = delete;
+
+    // Set before Start(): run ticks back to back instead of at the tick rate
+    void SetUnlocked(bool value) { unlocked = value; }
+    // Set before Start(): every shard stops after this many ticks (0 = run until Stop())
+    void SetTickLimit(uint64_t ticks) { tickLimit = ticks; }
+
+    float Step() const { return step; }
+    size_t ShardCount() const { return shards.size(); }
+
+    // Places the scene on the least loaded shard; may be called while running
+    size_t AddScene(std::unique_ptr<Scene> scene) {
+        std::lock_guard<std::mutex> lock(mutex);
+        size_t target = 0;
+        for (size_t i = 1; i < shards.size(); i++) {
+            if (shards[i]->load < shards[target]->load) target = i;
+        }
+
+        auto entry = std::make_unique<Entry>();
+        entry->scene = std::move(scene);
+        entry->stats.id = placement.size();
+        entry->stats.shard = target;
+        size_t id = entry->stats.id;
+        placement.push_back(target);
+
+        Shard& shard = *shards[target];
+        shard.load++;
+        std::lock_guard<std::mutex> shardLock(shard.mutex);
+        shard.pending.push_back(std::move(entry));
+        return id;
+    }
+
+    // The scene is destroyed by its shard before the next tick
+    void RemoveScene(size_t id) {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (id >= placement.size() || placement[id] == Removed) return;
+
+        Shard& shard = *shards[placement[id]];
+        placement[id] = Removed;
+        shard.load--;
+
+        std::lock_guard<std::mutex> shardLock(shard.mutex);
+        auto it = std::find_if(shard.pending.begin(), shard.pending.end(),
+            [id](const std::unique_ptr<Entry>& e) { return e->stats.id == id; });
+        if (it != shard.pending.end()) shard.pending.erase(it);
+        else shard.removed.push_back(id);
+    }
+
+    void Start() {
+        std::lock_guard<std::mutex> lock(mutex);
+        if (started) return;
+        started = true;
+        for (size_t i = 0; i < shards.size(); i++) {
+            Shard* shard = shards[i].get();
+            shard->thread = std::thread([this, shard, i] { ShardMain(*shard, i); });
+        }
+    }
+
+    void Stop() {
+        stopping = true;
+        for (auto& shard : shards) {
+            if (shard->thread.joinable()) shard->thread.join();
+        }
+    }
+
+    // True once every shard has reached the tick limit
+    bool Finished() const { return started && finishedShards == shards.size(); }
+
+    // Per-scene stats as of the last completed tick of each shard
+    std::vector<SceneStats> GetStats() {
+        std::vector<SceneStats> all;
+        for (auto& shard : shards) {
+            std::lock_guard<std::mutex> lock(shard->mutex);
+            all.insert(all.end(), shard->published.begin(), shard->published.end());
+        }
+        return all;
+    }
+};
+
+#endif
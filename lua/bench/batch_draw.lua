@@ -0,0 +1,94 @@
+-- Per-call vs batched 2D primitives.
+-- Run with: MoonRay --script2d lua/bench/batch_draw.lua [--render-thread | --pipelined]
+-- Every mode runs for FRAMES frames, then prints the average Lua submit time and frame time.
+
+local N = 10000
+local FRAMES = 180
+local W, H = 400, 225          -- The 2D pass camera is centered on the window
+
+local modes = {
+    "DrawCircle",
+    "DrawCirclesBatch (table)",
+    "DrawCirclesBatch (FloatArray)",
+    "DrawCirclesBatch (FloatArray, per-instance colors)",
+    "DrawCirclesBatch (FloatArray, ColorArray)",
+    "DrawRectangle",
+    "DrawRectanglesBatch (FloatArray)",
+}
+
+local px, py, vx, vy = {}, {}, {}, {}
+local circles = FloatArray(N * 3)
+local rects = FloatArray(N * 4)
+local colors = FloatArray(N * 4)
+local packedColors = ColorArray(N)
+local packed = {}
+local color = Color(255, 160, 40, 255)
+local floor = math.floor     -- The per-call API takes integer coordinates
+
+for i = 1, N do
+    px[i] = GetRandomValue(-W, W)
+    py[i] = GetRandomValue(-H, H)
+    vx[i] = GetRandomValue(-100, 100)
+    vy[i] = GetRandomValue(-100, 100)
+    colors:Set(i * 4 - 3, GetRandomValue(64, 255), GetRandomValue(64, 255), GetRandomValue(64, 255), 255)
+    packedColors[i] = Color(colors[i * 4 - 3], colors[i * 4 - 2], colors[i * 4 - 1], 255)
+end
+
+local mode, frame = 1, 0
+local submitTotal, frameTotal = 0, 0
+local results = {}
+
+function OnUpdate(dt)
+    for i = 1, N do
+        local x, y = px[i] + vx[i] * dt, py[i] + vy[i] * dt
+        if x < -W or x > W then vx[i] = -vx[i] end
+        if y < -H or y > H then vy[i] = -vy[i] end
+        px[i], py[i] = x, y
+    end
+end
+
+local function Submit()
+    local name = modes[mode]
+    if name == "DrawCircle" then
+        for i = 1, N do DrawCircle(floor(px[i]), floor(py[i]), 2, color) end
+    elseif name == "DrawCirclesBatch (table)" then
+        for i = 1, N do
+            local k = i * 3
+            packed[k - 2], packed[k - 1], packed[k] = px[i], py[i], 2
+        end
+        DrawCirclesBatch(packed, color)
+    elseif name == "DrawRectangle" then
+        for i = 1, N do DrawRectangle(floor(px[i]), floor(py[i]), 3, 3, color) end
+    elseif name == "DrawRectanglesBatch (FloatArray)" then
+        for i = 1, N do rects:Set(i * 4 - 3, px[i], py[i], 3, 3) end
+        DrawRectanglesBatch(rects, color)
+    else
+        for i = 1, N do circles:Set(i * 3 - 2, px[i], py[i], 2) end
+        if name == "DrawCirclesBatch (FloatArray)" then DrawCirclesBatch(circles, color)
+        elseif name == "DrawCirclesBatch (FloatArray, ColorArray)" then DrawCirclesBatch(circles, packedColors)
+        else DrawCirclesBatch(circles, colors) end
+    end
+end
+
+function OnRender()
+    if mode > #modes then
+        for i, line in ipairs(results) do DrawText(line, -W + 10, -H + 10 + (i - 1) * 20, 16, RAYWHITE) end
+        return
+    end
+
+    local start = os.clock()
+    Submit()
+    submitTotal = submitTotal + (os.clock() - start)
+    frameTotal = frameTotal + GetFrameTime()
+    frame = frame + 1
+
+    DrawText(modes[mode], -W + 10, -H + 10, 20, RAYWHITE)
+
+    if frame == FRAMES then
+        local line = string.format("%-52s submit %7.3f ms  frame %7.3f ms",
+            modes[mode], submitTotal / FRAMES * 1000, frameTotal / FRAMES * 1000)
+        print(line)
+        results[#results + 1] = line
+        mode, frame, submitTotal, frameTotal = mode + 1, 0, 0, 0
+    end
+end
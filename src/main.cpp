@@ -18,38 +18,88 @@
 
 #include "raylib.h"
 #include <memory>
+#include <cstring>
+#include <cstdlib>
+#include <thread>
+#include <string>
+#include <vector>
+#include <iostream>
 #include "core/Scene.h"
+#include "core/RenderThread.h"
+#include "core/FramePipeline.h"
+#include "core/JobSystem.h"
+#include "core/FixedTimestep.h"
+#include "core/InputSnapshot.h"
 #include "core/GameObject.h"
 #include "Imgui/rlImGui.h"
 #include "components/GuiComponent.h"
+#include "components/LuaComponent.h"
+#include "components/Transform2D.h"
+#include "MoonRay/ScriptDebugUI.h"
 
 
 const char* TITLE = "MoonRay Build 1.0.4";
 const int WIDTH = 800;
 const int HEIGHT = 450;
 const int TARGET_FPS = 60;
+const int TICK_RATE = 60;       // Simulation ticks per second, override with --tick-rate N
 
 
 const Camera3D CAMERA_SETUP = { { 10.0f, 10.0f, 10.0f }, { 0.0f, 0.0f, 0.0f }, { 0.0f, 1.0f, 0.0f }, 45.0f, CAMERA_PERSPECTIVE };
 
 const Camera2D CAMERA_2D_SETUP = { { WIDTH / 2.0f, HEIGHT / 2.0f }, { 0.0f, 0.0f }, 0.0f, 1.0f };
 
-int main() {
+// Lua scripts given on the command line: --script (3D pass) and --script2d (2D pass).
+// --isolated gives each of them its own VM, updated on the job system.
+std::vector<std::string> worldScripts;
+std::vector<std::string> overlayScripts;
+bool isolatedScripts = false;
+
+void PopulateScene(Scene& scene) {
+    for (const auto& script : worldScripts) {
+        auto obj = std::make_unique<GameObject>();
+        obj->AddComponent<LuaScriptComponent>(script, isolatedScripts);
+        scene.AddGameObject(std::move(obj));
+    }
+    for (const auto& script : overlayScripts) {
+        auto obj = std::make_unique<GameObject>();
+        obj->AddComponent<Transform2DComponent>();
+        obj->AddComponent<LuaScriptComponent>(script, isolatedScripts);
+        scene.AddGameObject(std::move(obj));
+    }
+}
+
+// Inside the ImGui frame: F3 Lua VMs, F4 Lua profiler
+void DrawDebugWindows() {
+    MoonRay::DrawScriptDebugWindow();
+    MoonRay::DrawScriptProfilerWindow();
+}
+
+// Default mode: simulation and rendering on the main thread
+int RunSingleThreaded(int tickRate) {
 
     InitWindow(WIDTH, HEIGHT, TITLE);
     SetTargetFPS(TARGET_FPS);
     rlImGuiSetup(true);
 
+    JobSystem jobs;
     Scene scene;
+    scene.SetJobSystem(&jobs);
+    PopulateScene(scene);
 
     Camera camera = CAMERA_SETUP;
     Camera2D camera2d = CAMERA_2D_SETUP;
 
+    FixedTimestep timestep(tickRate);
+
     while (!WindowShouldClose()) {
-        float deltaTime = GetFrameTime();
+        InputSnapshot::Capture();
+        int ticks = timestep.Advance(GetFrameTime());
 
         UpdateCamera(&camera, CAMERA_ORBITAL);
-        scene.Update(deltaTime);
+        scene.SetCamera(camera);
+        for (int i = 0; i < ticks; i++) scene.FixedUpdate(timestep.Step());
+        scene.SetInterpolationAlpha(timestep.Alpha());
 
 
         BeginDrawing();
@@ -66,7 +116,10 @@ int main() {
 
             rlImGuiBegin(); 
                 // here u can draw imgui stuff
+                DrawDebugWindows();
             rlImGuiEnd();   
+
+            scene.CollectGarbage();
         EndDrawing();
     }
 
@@ -74,4 +127,126 @@ int main() {
     CloseWindow();
 
     return 0;
-}
\ No newline at end of file
+}
+
+// Update and record one frame into a RenderFrame (used by the threaded modes)
+void SimulateFrame(Scene& scene, Camera& camera, const Camera2D& camera2d, FixedTimestep& timestep, RenderFrame& frame) {
+    InputSnapshot::Capture();
+    int ticks = timestep.Advance(GetFrameTime());
+
+    UpdateCamera(&camera, CAMERA_ORBITAL);
+    scene.SetCamera(camera);
+    for (int i = 0; i < ticks; i++) scene.FixedUpdate(timestep.Step());
+    scene.SetInterpolationAlpha(timestep.Alpha());
+
+    frame.camera = camera;
+    frame.camera2D = camera2d;
+    frame.clearColor = BLACK;
+    scene.Record(frame.world);
+    scene.Record2D(frame.overlay);
+}
+
+// --render-thread: the render thread owns the window and GL context and replays
+// the frame recorded here, one frame behind the simulation
+int RunWithRenderThread(int tickRate) {
+
+    RenderThread renderer(WIDTH, HEIGHT, TITLE, TARGET_FPS, DrawDebugWindows);
+
+    JobSystem jobs;
+    Scene scene;
+    scene.SetJobSystem(&jobs);
+    PopulateScene(scene);
+
+    Camera camera = CAMERA_SETUP;
+    Camera2D camera2d = CAMERA_2D_SETUP;
+
+    FixedTimestep timestep(tickRate);
+
+    while (!renderer.ShouldClose()) {
+        SimulateFrame(scene, camera, camera2d, timestep, renderer.BeginFrame());
+        renderer.EndFrame();
+        scene.CollectGarbage();     // While the render thread replays the frame
+    }
+
+    return 0;
+}
+
+// --pipelined: the window stays on the main thread, which replays frame N while a
+// simulation thread (plus the job system workers) updates and records frame N+1
+int RunPipelined(int tickRate) {
+
+    InitWindow(WIDTH, HEIGHT, TITLE);
+    SetTargetFPS(TARGET_FPS);
+    rlImGuiSetup(true);
+
+    FramePipeline pipeline;
+    pipeline.BindConsumer();
+
+    std::thread simulation([&pipeline, tickRate] {
+        JobSystem jobs;
+        Scene scene;
+        scene.SetJobSystem(&jobs);
+        PopulateScene(scene);
+
+        Camera camera = CAMERA_SETUP;
+        Camera2D camera2d = CAMERA_2D_SETUP;
+
+        FixedTimestep timestep(tickRate);
+
+        while (RenderFrame* frame = pipeline.BeginFrame()) {
+            SimulateFrame(scene, camera, camera2d, timestep, *frame);
+            pipeline.EndFrame();
+            scene.CollectGarbage();
+        }
+    });
+
+    while (const RenderFrame* frame = pipeline.AcquireFrame()) {
+        ReplayFrame(*frame, DrawDebugWindows);
+        pipeline.WaitForNextFrame();
+        EndDrawing();
+        pipeline.FramePresented();
+        if (WindowShouldClose()) pipeline.Stop();
+    }
+
+    pipeline.Stop();
+    simulation.join();
+
+    rlImGuiShutdown();
+    CloseWindow();
+
+    return 0;
+}
+
+int main(int argc, char** argv) {
+    bool renderThread = false;
+    bool pipelined = false;
+    int tickRate = TICK_RATE;
+    std::string profileOutput;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--render-thread") == 0) renderThread = true;
+        else if (strcmp(argv[i], "--pipelined") == 0) pipelined = true;
+        else if (strcmp(argv[i], "--tick-rate") == 0 && i + 1 < argc) tickRate = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--script") == 0 && i + 1 < argc) worldScripts.push_back(argv[++i]);
+        else if (strcmp(argv[i], "--script2d") == 0 && i + 1 < argc) overlayScripts.push_back(argv[++i]);
+        else if (strcmp(argv[i], "--isolated") == 0) isolatedScripts = true;
+        else if (strcmp(argv[i], "--hot-reload") == 0) MoonRay::ScriptWatcher::Get().Start();
+        else if (strcmp(argv[i], "--gc-budget") == 0 && i + 1 < argc) MoonRay::ScriptVM::DefaultGCBudget() = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--memory-limit") == 0 && i + 1 < argc) MoonRay::ScriptVM::DefaultMemoryLimit() = (size_t)atoi(argv[++i]) << 20;
+        else if (strcmp(argv[i], "--script-budget") == 0 && i + 1 < argc) MoonRay::ScriptVM::DefaultInstructionBudget() = atoll(argv[++i]);
+        else if (strcmp(argv[i], "--script-timeout") == 0 && i + 1 < argc) MoonRay::ScriptVM::DefaultTimeLimit() = atoi(argv[++i]) * 1000;
+        else if (strcmp(argv[i], "--profile") == 0 && i + 1 < argc) profileOutput = argv[++i];
+    }
+
+    // Profiles from the first frame and writes the folded stacks on exit
+    if (!profileOutput.empty()) MoonRay::ScriptProfiler::Get().Start();
+
+    int result;
+    if (renderThread) result = RunWithRenderThread(tickRate);
+    else if (pipelined) result = RunPipelined(tickRate);
+    else result = RunSingleThreaded(tickRate);
+
+    if (!profileOutput.empty() && !MoonRay::ScriptProfiler::Get().Export(profileOutput)) {
+        std::cerr << "Can't write " << profileOutput << std::endl;
+    }
+    return result;
+}
@@ -0,0 +1,155 @@
+/*
+ * Copyright (C) 2026 Artem Svitlov (Moscow, Russia)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// Null platform for the headless server build: the part of the raylib API that the engine headers
+// and the Lua bindings call, implemented without a window, GL or audio. Drawing never reaches
+// raylib in this build (RenderQueue::Execute is compiled out with MOONRAY_HEADLESS).
+
+#include "raylib.h"
+#include "core/Headless.h"
+#include <chrono>
+#include <cmath>
+#include <cstdlib>
+
+namespace {
+    const auto startTime = std::chrono::steady_clock::now();
+    float frameTime = 1.0f / 60.0f;
+
+    unsigned char HueChannel(float hue, float saturation, float value, float offset) {
+        float k = fmodf(offset + hue / 60.0f, 6.0f);
+        float t = 4.0f - k;
+        k = (t < k) ? t : k;
+        k = (k < 1.0f) ? k : 1.0f;
+        k = (k > 0.0f) ? k : 0.0f;
+        return (unsigned char)((value - value * saturation * k) * 255.0f);
+    }
+}
+
+void MoonRay::Headless::SetFrameTime(float seconds) { frameTime = seconds; }
+
+// --- Window ---
+
+void InitWindow(int width, int height, const char* title) {}
+void CloseWindow(void) {}
+bool WindowShouldClose(void) { return false; }
+void SetTargetFPS(int fps) {}
+
+// --- Drawing ---
+
+void BeginDrawing(void) {}
+void EndDrawing(void) {}
+void ClearBackground(Color color) {}
+void BeginMode2D(Camera2D camera) {}
+void EndMode2D(void) {}
+void BeginMode3D(Camera3D camera) {}
+void EndMode3D(void) {}
+void UpdateCamera(Camera* camera, int mode) {}
+
+// --- Input: nothing is ever pressed ---
+
+bool IsKeyDown(int key) { return false; }
+bool IsKeyPressed(int key) { return false; }
+bool IsKeyReleased(int key) { return false; }
+bool IsKeyUp(int key) { return true; }
+int GetKeyPressed(void) { return 0; }
+int GetCharPressed(void) { return 0; }
+
+int GetMouseX(void) { return 0; }
+int GetMouseY(void) { return 0; }
+Vector2 GetMousePosition(void) { return { 0.0f, 0.0f }; }
+Vector2 GetMouseDelta(void) { return { 0.0f, 0.0f }; }
+float GetMouseWheelMove(void) { return 0.0f; }
+bool IsMouseButtonDown(int button) { return false; }
+bool IsMouseButtonPressed(int button) { return false; }
+bool IsMouseButtonReleased(int button) { return false; }
+bool IsMouseButtonUp(int button) { return true; }
+bool IsGamepadAvailable(int gamepad) { return false; }
+bool IsGamepadButtonDown(int gamepad, int button) { return false; }
+float GetGamepadAxisMovement(int gamepad, int axis) { return 0.0f; }
+
+// --- Timing ---
+
+float GetFrameTime(void) { return frameTime; }
+
+double GetTime(void) {
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - startTime).count();
+}
+
+int GetFPS(void) { return frameTime > 0.0f ? (int)roundf(1.0f / frameTime) : 0; }
+
+// --- Colors (same math as raylib) ---
+
+Color ColorFromHSV(float hue, float saturation, float value) {
+    return {
+        HueChannel(hue, saturation, value, 5.0f),
+        HueChannel(hue, saturation, value, 3.0f),
+        HueChannel(hue, saturation, value, 1.0f),
+        255
+    };
+}
+
+Color ColorAlpha(Color color, float alpha) {
+    if (alpha < 0.0f) alpha = 0.0f;
+    else if (alpha > 1.0f) alpha = 1.0f;
+    color.a = (unsigned char)(255.0f * alpha);
+    return color;
+}
+
+Color ColorAlphaBlend(Color dst, Color src, Color tint) {
+    Color out = WHITE;
+
+    src.r = (unsigned char)(((unsigned int)src.r * ((unsigned int)tint.r + 1)) >> 8);
+    src.g = (unsigned char)(((unsigned int)src.g * ((unsigned int)tint.g + 1)) >> 8);
+    src.b = (unsigned char)(((unsigned int)src.b * ((unsigned int)tint.b + 1)) >> 8);
+    src.a = (unsigned char)(((unsigned int)src.a * ((unsigned int)tint.a + 1)) >> 8);
+
+    if (src.a == 0) out = dst;
+    else if (src.a == 255) out = src;
+    else {
+        unsigned int alpha = (unsigned int)src.a + 1;
+        out.a = (unsigned char)((alpha * 256 + (unsigned int)dst.a * (256 - alpha)) >> 8);
+
+        if (out.a > 0) {
+            out.r = (unsigned char)((((unsigned int)src.r * alpha * 256 + (unsigned int)dst.r * (unsigned int)dst.a * (256 - alpha)) / out.a) >> 8);
+            out.g = (unsigned char)((((unsigned int)src.g * alpha * 256 + (unsigned int)dst.g * (unsigned int)dst.a * (256 - alpha)) / out.a) >> 8);
+            out.b = (unsigned char)((((unsigned int)src.b * alpha * 256 + (unsigned int)dst.b * (unsigned int)dst.a * (256 - alpha)) / out.a) >> 8);
+        }
+    }
+    return out;
+}
+
+// --- Resources: nothing to upload, scripts get an empty texture ---
+
+Texture2D LoadTexture(const char* fileName) { return { 0, 0, 0, 0, 0 }; }
+void UnloadTexture(Texture2D texture) {}
+
+// --- Audio ---
+
+void InitAudioDevice(void) {}
+void CloseAudioDevice(void) {}
+void PlaySound(Sound sound) {}
+
+// --- Misc ---
+
+int GetRandomValue(int min, int max) {
+    if (min > max) {
+        int tmp = max;
+        max = min;
+        min = tmp;
+    }
+    return min + rand() % (max - min + 1);
+}
@@ -0,0 +1,138 @@
+/*
+ * Copyright (C) 2026 Artem Svitlov (Moscow, Russia)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// Headless dedicated server: runs Scene updates and Lua scripts on a fixed tick without a window.
+//
+//   MoonRayServer [--tick-rate N] [--unlocked] [--ticks N] [--rooms N] [--threads N] [--hot-reload] [--gc-budget US] [--memory-limit MB] [--script-budget N] [--script-timeout MS] [--profile FILE] script.lua [...]
+//
+// Every room is an isolated Scene with one GameObject per script. Rooms are spread over
+// --threads shard threads by SceneHost (default: one per core, at most one per room).
+// --unlocked runs the ticks back to back (still advancing by 1/N per tick), which is what
+// batch simulations and benchmarks want. --ticks stops after N ticks, otherwise the server
+// runs until SIGINT/SIGTERM. --hot-reload swaps edited scripts into the running rooms.
+// --gc-budget sets the Lua GC time per room and tick (0 = Lua's automatic collector).
+// --memory-limit caps every room's Lua heap; scripts over it get "not enough memory" errors.
+// --script-budget / --script-timeout stop a script call after N VM instructions / MS milliseconds
+// (default: both off); the script is suspended and reported.
+// --profile samples the scripts of every room and writes folded stacks to FILE on exit.
+
+#include "raylib.h"
+#include <memory>
+#include <cstring>
+#include <cstdlib>
+#include <csignal>
+#include <chrono>
+#include <thread>
+#include <vector>
+#include <string>
+#include <algorithm>
+#include <iostream>
+#include "core/Headless.h"
+#include "core/Scene.h"
+#include "core/SceneHost.h"
+#include "core/GameObject.h"
+#include "components/LuaComponent.h"
+
+
+const int TICK_RATE = 60;
+
+
+volatile std::sig_atomic_t stopRequested = 0;
+
+void RequestStop(int) { stopRequested = 1; }
+
+std::unique_ptr<Scene> BuildRoom(const std::vector<std::string>& scripts) {
+    auto scene = std::make_unique<Scene>();
+    for (const auto& script : scripts) {
+        auto obj = std::make_unique<GameObject>();
+        obj->AddComponent<LuaScriptComponent>(script);
+        scene->AddGameObject(std::move(obj));
+    }
+    return scene;
+}
+
+int main(int argc, char** argv) {
+    int tickRate = TICK_RATE;
+    bool unlocked = false;
+    long long maxTicks = 0;
+    int rooms = 1;
+    int threads = 0;
+    std::vector<std::string> scripts;
+    std::string profileOutput;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--tick-rate") == 0 && i + 1 < argc) tickRate = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--unlocked") == 0) unlocked = true;
+        else if (strcmp(argv[i], "--ticks") == 0 && i + 1 < argc) maxTicks = atoll(argv[++i]);
+        else if (strcmp(argv[i], "--rooms") == 0 && i + 1 < argc) rooms = std::max(1, atoi(argv[++i]));
+        else if (strcmp(argv[i], "--threads") == 0 && i + 1 < argc) threads = std::max(0, atoi(argv[++i]));
+        else if (strcmp(argv[i], "--hot-reload") == 0) MoonRay::ScriptWatcher::Get().Start();
+        else if (strcmp(argv[i], "--gc-budget") == 0 && i + 1 < argc) MoonRay::ScriptVM::DefaultGCBudget() = atoi(argv[++i]);
+        else if (strcmp(argv[i], "--memory-limit") == 0 && i + 1 < argc) MoonRay::ScriptVM::DefaultMemoryLimit() = (size_t)atoi(argv[++i]) << 20;
+        else if (strcmp(argv[i], "--script-budget") == 0 && i + 1 < argc) MoonRay::ScriptVM::DefaultInstructionBudget() = atoll(argv[++i]);
+        else if (strcmp(argv[i], "--script-timeout") == 0 && i + 1 < argc) MoonRay::ScriptVM::DefaultTimeLimit() = atoi(argv[++i]) * 1000;
+        else if (strcmp(argv[i], "--profile") == 0 && i + 1 < argc) profileOutput = argv[++i];
+        else scripts.push_back(argv[i]);
+    }
+
+    std::signal(SIGINT, RequestStop);
+    std::signal(SIGTERM, RequestStop);
+
+    if (threads == 0) threads = (int)std::max(1u, std::thread::hardware_concurrency());
+    threads = std::min(threads, rooms);
+
+    SceneHost host((size_t)threads, tickRate);
+    host.SetUnlocked(unlocked);
+    host.SetTickLimit(maxTicks > 0 ? (uint64_t)maxTicks : 0);
+    MoonRay::Headless::SetFrameTime(host.Step());
+
+    for (int i = 0; i < rooms; i++) host.AddScene(BuildRoom(scripts));
+
+    if (!profileOutput.empty()) MoonRay::ScriptProfiler::Get().Start();
+
+    using Clock = std::chrono::steady_clock;
+    const auto start = Clock::now();
+    host.Start();
+    while (!stopRequested && !host.Finished()) std::this_thread::sleep_for(std::chrono::milliseconds(50));
+    std::vector<SceneStats> stats = host.GetStats();
+    host.Stop();
+    if (!profileOutput.empty() && !MoonRay::ScriptProfiler::Get().Export(profileOutput)) {
+        std::cerr << "Can't write " << profileOutput << std::endl;
+    }
+    double wall = std::chrono::duration<double>(Clock::now() - start).count();
+
+    uint64_t sceneTicks = 0;
+    double busyMs = 0.0;
+    for (const auto& s : stats) {
+        sceneTicks += s.ticks;
+        busyMs += s.totalMs;
+    }
+    std::sort(stats.begin(), stats.end(), [](const SceneStats& a, const SceneStats& b) { return a.avgTickMs > b.avgTickMs; });
+
+    std::cout << "rooms: " << rooms << "  threads: " << threads
+              << "  wall: " << wall << " s"
+              << "  scene ticks: " << sceneTicks
+              << "  rate: " << (wall > 0.0 ? sceneTicks / wall : 0.0) << " scene ticks/s"
+              << "  avg tick: " << (sceneTicks ? busyMs / sceneTicks : 0.0) << " ms" << std::endl;
+
+    // Most expensive rooms first
+    for (size_t i = 0; i < stats.size() && i < 8; i++) {
+        std::cout << "  room " << stats[i].id << " (shard " << stats[i].shard << "): "
+                  << stats[i].avgTickMs << " ms avg, " << stats[i].maxTickMs << " ms max" << std::endl;
+    }
+
+    return 0;
+}
@@ -0,0 +1,75 @@
+/*
+ * Copyright (C) 2026 Artem Svitlov (Moscow, Russia)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// Offline LOD generator: lodgen <model> <output prefix> [ratio ...]
+// Writes <prefix>_lod<N>.obj (one file per mesh: <prefix>_lod<N>_<mesh>.obj) for every ratio.
+
+
+#include "raylib.h"
+#include "core/MeshSimplifier.h"
+#include <cstdio>
+#include <cstdlib>
+#include <string>
+#include <vector>
+
+int main(int argc, char** argv) {
+    if (argc < 3) {
+        printf("usage: %s <model> <output prefix> [ratio ...]\n", argv[0]);
+        printf("default ratios: 0.5 0.25 0.125\n");
+        return 1;
+    }
+
+    std::vector<float> ratios;
+    for (int i = 3; i < argc; i++) ratios.push_back((float)atof(argv[i]));
+    if (ratios.empty()) ratios = { 0.5f, 0.25f, 0.125f };
+
+    // LoadModel() uploads meshes, so a (hidden) GL context is required
+    SetConfigFlags(FLAG_WINDOW_HIDDEN);
+    SetTraceLogLevel(LOG_WARNING);
+    InitWindow(1, 1, "lodgen");
+
+    Model model = LoadModel(argv[1]);
+    if (model.meshCount == 0) {
+        fprintf(stderr, "lodgen: failed to load %s\n", argv[1]);
+        CloseWindow();
+        return 1;
+    }
+
+    int failures = 0;
+    for (size_t lod = 0; lod < ratios.size(); lod++) {
+        for (int m = 0; m < model.meshCount; m++) {
+            Mesh simplified = MoonRay::SimplifyMesh(model.meshes[m], ratios[lod]);
+
+            std::string out = std::string(argv[2]) + "_lod" + std::to_string(lod + 1);
+            if (model.meshCount > 1) out += "_" + std::to_string(m);
+            out += ".obj";
+
+            if (ExportMesh(simplified, out.c_str())) {
+                printf("[LOD %zu] %s: %d -> %d triangles\n", lod + 1, out.c_str(),
+                       model.meshes[m].triangleCount, simplified.triangleCount);
+            } else {
+                fprintf(stderr, "lodgen: failed to write %s\n", out.c_str());
+                failures++;
+            }
+            UnloadMesh(simplified);
+        }
+    }
+
+    UnloadModel(model);
+    CloseWindow();
+    return failures == 0 ? 0 : 1;
+}
@@ -0,0 +1,71 @@
+/*
+ * Copyright (C) 2026 Artem Svitlov (Moscow, Russia)
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU Affero General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU Affero General Public License for more details.
+ *
+ * You should have received a copy of the GNU Affero General Public License
+ * along with this program.  If not, see <https://www.gnu.org/licenses/>.
+ */
+
+// Offline Lua precompiler: luacache [--cache <dir>] <script or directory> ...
+// Fills the bytecode cache (MoonRay/BytecodeCache.h) for every .lua file, so the first start
+// doesn't compile anything. Entries that are already up to date are left alone. Run it from
+// the directory the game starts in, with the same relative paths the game loads.
+
+
+#include "lua.hpp"
+#include "MoonRay/BytecodeCache.h"
+#include <cstdio>
+#include <cstring>
+#include <string>
+#include <vector>
+#include <filesystem>
+
+int main(int argc, char** argv) {
+    std::vector<std::string> scripts;
+    for (int i = 1; i < argc; i++) {
+        if (strcmp(argv[i], "--cache") == 0 && i + 1 < argc) {
+            MoonRay::BytecodeCache::Directory() = argv[++i];
+            continue;
+        }
+
+        std::error_code ec;
+        if (std::filesystem::is_directory(argv[i], ec)) {
+            for (const auto& file : std::filesystem::recursive_directory_iterator(argv[i], ec)) {
+                if (file.is_regular_file() && file.path().extension() == ".lua") scripts.push_back(file.path().string());
+            }
+        } else {
+            scripts.push_back(argv[i]);
+        }
+    }
+
+    if (scripts.empty() || MoonRay::BytecodeCache::Directory().empty()) {
+        printf("usage: %s [--cache <dir>] <script or directory> ...\n", argv[0]);
+        printf("default cache: %s\n", MoonRay::BytecodeCache::Directory().c_str());
+        return 1;
+    }
+
+    lua_State* L = luaL_newstate();
+    int failures = 0;
+    for (const auto& script : scripts) {
+        if (MoonRay::BytecodeCache::LoadScript(L, script) == LUA_OK) {
+            printf("[LUAC] %s\n", script.c_str());
+        } else {
+            fprintf(stderr, "luacache: %s\n", lua_tostring(L, -1));
+            failures++;
+        }
+        lua_settop(L, 0);
+    }
+    lua_close(L);
+
+    printf("%zu scripts, %d failed, cache in %s\n", scripts.size(), failures, MoonRay::BytecodeCache::Directory().c_str());
+    return failures == 0 ? 0 : 1;
+}